@@ -0,0 +1,42 @@
+#include "curve_points.h"
+#include <algorithm>
+
+void CurvePoints::assign(const uint8_t* temps, const uint8_t* curve_values, size_t count) {
+    points.resize(count);
+    order.resize(count);
+    rank.resize(count);
+    for (size_t id = 0; id < count; ++id) {
+        // Curve values are 0-100; the plot shows them as RPM
+        points[id] = { temps[id], curve_values[id] * 100 };
+        order[id] = id;
+    }
+    std::sort(order.begin(), order.end(), [this](size_t a, size_t b) { return before(a, b); });
+    for (size_t r = 0; r < count; ++r) {
+        rank[order[r]] = r;
+    }
+}
+
+void CurvePoints::swapRanks(size_t r1, size_t r2) {
+    std::swap(order[r1], order[r2]);
+    rank[order[r1]] = r1;
+    rank[order[r2]] = r2;
+}
+
+void CurvePoints::move(size_t id, int temp, int rpm, size_t& firstRank, size_t& lastRank) {
+    points[id].temp = temp;
+    points[id].rpm = rpm;
+
+    // Insertion step: walk the point towards its new place one neighbour at a time
+    const size_t start = rank[id];
+    size_t r = start;
+    while (r > 0 && before(id, order[r - 1])) {
+        swapRanks(r, r - 1);
+        --r;
+    }
+    while (r + 1 < order.size() && before(order[r + 1], id)) {
+        swapRanks(r, r + 1);
+        ++r;
+    }
+    firstRank = std::min(start, r);
+    lastRank = std::max(start, r);
+}
@@ -0,0 +1,46 @@
+#ifndef CURVE_POINTS_H
+#define CURVE_POINTS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct PlotPoint {
+    int temp;
+    int rpm;
+};
+
+// Editable fan curve points with a temperature-sorted view. Points are stored by id (their
+// index in the EC tables), which never changes, so ImPlot::DragPoint IDs and writes back to
+// the tables stay tied to the same point however the curve is reordered.
+//
+// The sorted order is kept as a permutation (order: rank -> id, rank: id -> rank). Moving one
+// point repairs it with adjacent swaps, so a drag costs O(distance moved) instead of a full
+// sort. Ties in temperature are ordered by id.
+class CurvePoints {
+public:
+    // Replaces all points (curve_values on the EC's 0-100 scale) and sorts them: reload only
+    void assign(const uint8_t* temps, const uint8_t* curve_values, size_t count);
+
+    size_t size() const { return points.size(); }
+
+    const PlotPoint& point(size_t id) const { return points[id]; }
+    size_t idAt(size_t sortedRank) const { return order[sortedRank]; }
+    size_t rankOf(size_t id) const { return rank[id]; }
+
+    // Moves point id and restores the sorted order. [firstRank, lastRank] is set to the ranks
+    // whose point changed: the point's old and new rank and everything in between.
+    void move(size_t id, int temp, int rpm, size_t& firstRank, size_t& lastRank);
+
+private:
+    std::vector<PlotPoint> points; // By id
+    std::vector<size_t> order;     // Sorted rank -> id
+    std::vector<size_t> rank;      // Id -> sorted rank
+
+    bool before(size_t a, size_t b) const {
+        return points[a].temp < points[b].temp || (points[a].temp == points[b].temp && a < b);
+    }
+    void swapRanks(size_t r1, size_t r2);
+};
+
+#endif // CURVE_POINTS_H
@@ -0,0 +1,74 @@
+// Syscalls per EC snapshot on the /dev/port backend. Runs full readStatus snapshots and
+// telemetry polls through DevPortBackend and prints how many syscalls and port ops each
+// took; with io_uring a table sweep is one io_uring_enter instead of one pread/pwrite per op.
+// Built only with -DFAN_CONTROL_BENCH=ON.
+//
+// Usage: DevPortBench [path]   (default: a zero-filled stand-in file instead of /dev/port)
+#include "fan_control.h"
+#include <stdio.h>
+#include <chrono>
+#include <string>
+
+namespace {
+    const int ROUNDS = 100;
+
+    bool makeStandIn(const std::string& path) {
+        FILE* file = fopen(path.c_str(), "wb");
+        if (file == nullptr) {
+            return false;
+        }
+        static const char zeros[0x100] = {}; // Covers ports 0x4E/0x4F
+        const bool ok = fwrite(zeros, 1, sizeof(zeros), file) == sizeof(zeros);
+        fclose(file);
+        return ok;
+    }
+
+    void report(const char* what, uint64_t syscalls, uint64_t portOps, std::chrono::steady_clock::duration elapsed) {
+        const double us = std::chrono::duration<double, std::micro>(elapsed).count();
+        printf("%-10s %8.1f syscalls, %8.1f port ops, %8.1f us per call\n", what,
+               static_cast<double>(syscalls) / ROUNDS, static_cast<double>(portOps) / ROUNDS, us / ROUNDS);
+    }
+} // end anonymous namespace
+
+int main(int argc, char* argv[]) {
+    typedef std::chrono::steady_clock Clock;
+
+    std::string path = argc > 1 ? argv[1] : "dev_port_bench.standin";
+    if (argc <= 1 && !makeStandIn(path)) {
+        printf("Could not create stand-in file %s\n", path.c_str());
+        return 1;
+    }
+
+    DevPortBackend* backend = new DevPortBackend(path);
+    FanController controller{ std::unique_ptr<PortBackend>(backend) };
+    if (!controller.initialize()) {
+        printf("initialize failed: %s\n", controller.getLastError().c_str());
+        return 1;
+    }
+    printf("Backend: %s on %s, %d rounds\n", backend->name(), path.c_str(), ROUNDS);
+
+    FanStatusData status;
+    backend->resetCounters();
+    Clock::time_point start = Clock::now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        if (!controller.readStatus(status)) {
+            printf("readStatus failed: %s\n", controller.getLastError().c_str());
+            return 1;
+        }
+    }
+    report("snapshot", backend->syscalls(), backend->portOps(), Clock::now() - start);
+
+    backend->resetCounters();
+    start = Clock::now();
+    for (int i = 0; i < ROUNDS; ++i) {
+        if (!controller.pollStatus(status)) {
+            printf("pollStatus failed: %s\n", controller.getLastError().c_str());
+            return 1;
+        }
+    }
+    report("poll", backend->syscalls(), backend->portOps(), Clock::now() - start);
+
+    // Without batching every port op is its own pread/pwrite
+    printf("Per-op /dev/port access would need one syscall per port op.\n");
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "ec_lock.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+#ifdef _WIN32
+    // Name used by hardware monitoring tools to arbitrate embedded controller access
+    const wchar_t* EC_MUTEX_NAME = L"Global\\Access_EC";
+#else
+    // /run/lock is the standard place for lock files. No /tmp fallback: anyone can plant a
+    // file or symlink there ahead of us.
+    const char* EC_LOCK_PATH = "/run/lock/superio-ec.lock";
+#endif
+}
+
+EcSystemLock::EcSystemLock() {}
+
+EcSystemLock::~EcSystemLock() {
+    close();
+}
+
+bool EcSystemLock::isOpen() const {
+    return handle != nullptr || fd >= 0;
+}
+
+#ifdef _WIN32
+
+bool EcSystemLock::open(std::string& error) {
+    if (isOpen()) {
+        return true;
+    }
+    handle = CreateMutexW(NULL, FALSE, EC_MUTEX_NAME);
+    if (!handle) {
+        error = "Failed to create EC arbitration mutex (Global\\Access_EC). Error code: " + std::to_string(GetLastError());
+        return false;
+    }
+    return true;
+}
+
+void EcSystemLock::close() {
+    if (handle) {
+        CloseHandle((HANDLE)handle);
+        handle = nullptr;
+    }
+}
+
+bool EcSystemLock::acquire(std::chrono::milliseconds timeout) {
+    const Clock::time_point start = Clock::now();
+    DWORD wait = WaitForSingleObject((HANDLE)handle, 0); // Uncontended fast path
+    const bool contended = wait == WAIT_TIMEOUT;
+    if (contended) {
+        wait = WaitForSingleObject((HANDLE)handle, static_cast<DWORD>(timeout.count()));
+    }
+    if (wait == WAIT_ABANDONED) {
+        ++lock_stats.abandoned; // Still ours; the EC latch state is unknown, which callers assume anyway
+    } else if (wait != WAIT_OBJECT_0) {
+        ++lock_stats.timeouts;
+        return false;
+    }
+    noteAcquired(start, contended);
+    return true;
+}
+
+void EcSystemLock::release() {
+    const Clock::duration held = Clock::now() - acquired_at;
+    ReleaseMutex((HANDLE)handle);
+    lock_stats.total_hold += held;
+    if (held > lock_stats.max_hold) lock_stats.max_hold = held;
+}
+
+#else
+
+bool EcSystemLock::open(std::string& error) {
+    if (isOpen()) {
+        return true;
+    }
+    // Never follow a symlink, and only widen the mode of a file this process created
+    fd = ::open(EC_LOCK_PATH, O_RDWR | O_CREAT | O_EXCL | O_NOFOLLOW | O_CLOEXEC, 0666);
+    const bool created = fd >= 0;
+    if (!created && errno == EEXIST) {
+        fd = ::open(EC_LOCK_PATH, O_RDWR | O_NOFOLLOW | O_CLOEXEC);
+    }
+    if (fd < 0) {
+        error = std::string("Failed to open EC arbitration lock file ") + EC_LOCK_PATH + ": " + std::strerror(errno);
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || !S_ISREG(st.st_mode)) {
+        close();
+        error = std::string("EC arbitration lock file ") + EC_LOCK_PATH + " is not a regular file";
+        return false;
+    }
+    if (created) {
+        fchmod(fd, 0666); // Let other users' tools share it despite our umask
+    }
+    return true;
+}
+
+void EcSystemLock::close() {
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+bool EcSystemLock::acquire(std::chrono::milliseconds timeout) {
+    const Clock::time_point start = Clock::now();
+    if (flock(fd, LOCK_EX | LOCK_NB) == 0) { // Uncontended fast path
+        noteAcquired(start, false);
+        return true;
+    }
+
+    // flock has no timed wait; poll with a short backoff until the deadline
+    const Clock::time_point deadline = start + timeout;
+    std::chrono::microseconds backoff(50);
+    while (Clock::now() < deadline) {
+        std::this_thread::sleep_for(backoff);
+        if (flock(fd, LOCK_EX | LOCK_NB) == 0) {
+            noteAcquired(start, true);
+            return true;
+        }
+        if (errno != EWOULDBLOCK && errno != EINTR) {
+            break;
+        }
+        if (backoff < std::chrono::microseconds(1000)) {
+            backoff *= 2;
+        }
+    }
+    ++lock_stats.timeouts;
+    return false;
+}
+
+void EcSystemLock::release() {
+    const Clock::duration held = Clock::now() - acquired_at;
+    flock(fd, LOCK_UN);
+    lock_stats.total_hold += held;
+    if (held > lock_stats.max_hold) lock_stats.max_hold = held;
+}
+
+#endif
+
+void EcSystemLock::noteAcquired(Clock::time_point start, bool contended) {
+    acquired_at = Clock::now();
+    const Clock::duration waited = acquired_at - start;
+    ++lock_stats.acquisitions;
+    if (contended) ++lock_stats.contended;
+    lock_stats.total_wait += waited;
+    if (waited > lock_stats.max_wait) lock_stats.max_wait = waited;
+}
@@ -0,0 +1,94 @@
+#ifndef EC_LOCK_H
+#define EC_LOCK_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Re-entrant lock serializing whole EC transactions within the process. An EC access is a
+// multi-op index/data sequence on shared ports, so two threads must never interleave one.
+// Re-entrant so a caller holding a transaction can call the public FanController methods,
+// which take the lock themselves. The uncontended path is one try_lock; only a failed
+// try_lock counts as contention and blocks.
+class EcTransactionLock {
+public:
+    void lock() {
+        const std::thread::id self = std::this_thread::get_id();
+        if (owner.load(std::memory_order_relaxed) == self) {
+            ++depth; // Already ours
+            return;
+        }
+        if (!mutex.try_lock()) {
+            contentions.fetch_add(1, std::memory_order_relaxed);
+            mutex.lock();
+        }
+        owner.store(self, std::memory_order_relaxed);
+        depth = 1;
+    }
+
+    void unlock() {
+        if (--depth == 0) {
+            owner.store(std::thread::id(), std::memory_order_relaxed);
+            mutex.unlock();
+        }
+    }
+
+    // Number of lock() calls that found the lock held by another thread
+    uint64_t contentionCount() const { return contentions.load(std::memory_order_relaxed); }
+
+private:
+    std::mutex mutex;
+    std::atomic<std::thread::id> owner{};
+    unsigned depth = 0; // Only touched by the owner
+    std::atomic<uint64_t> contentions{0};
+};
+
+// Wait and hold statistics of an EcSystemLock
+struct EcLockStats {
+    uint64_t acquisitions = 0;
+    uint64_t contended = 0; // Acquisitions that found the lock held and had to wait
+    uint64_t timeouts = 0;
+    uint64_t abandoned = 0; // Windows: the previous owner exited while holding it
+    std::chrono::nanoseconds total_wait{0};
+    std::chrono::nanoseconds max_wait{0};
+    std::chrono::nanoseconds total_hold{0};
+    std::chrono::nanoseconds max_hold{0};
+};
+
+// System-wide lock shared with every other program that drives the SuperIO ports (vendor
+// utilities, monitoring tools, another FanControlGUI). On Windows this is the
+// "Global\\Access_EC" named mutex that hardware monitoring tools already agree on; on Linux
+// it is an flock on a lock file, which the kernel releases if the holder dies.
+// Not thread-safe on its own; FanController only touches it under its EcTransactionLock.
+class EcSystemLock {
+public:
+    EcSystemLock();
+    ~EcSystemLock();
+
+    // Creates or opens the shared lock object. On failure returns false and describes why in error.
+    bool open(std::string& error);
+    void close();
+    bool isOpen() const;
+
+    // Waits up to timeout for the lock. Returns false if it is still held elsewhere.
+    bool acquire(std::chrono::milliseconds timeout);
+    void release();
+
+    const EcLockStats& stats() const { return lock_stats; }
+    void resetStats() { lock_stats = EcLockStats(); }
+
+private:
+    typedef std::chrono::steady_clock Clock;
+
+    void* handle = nullptr; // Windows mutex HANDLE
+    int fd = -1;            // Linux lock file
+    Clock::time_point acquired_at;
+    EcLockStats lock_stats;
+
+    void noteAcquired(Clock::time_point start, bool contended);
+};
+
+#endif // EC_LOCK_H
@@ -0,0 +1,84 @@
+#ifndef EC_PROTOCOL_H
+#define EC_PROTOCOL_H
+
+#include <cstddef>
+#include <cstdint>
+
+// ITE SuperIO -> D2EC indirect EC RAM access, shared by port backends that run whole
+// index/data sequences themselves. SuperIO register 0x2E selects a D2EC register and 0x2F
+// accesses it; D2EC 0x11/0x10 hold the EC address high/low byte and 0x12 is the data byte.
+//
+// The templates take an Io type providing
+//     void in(uint16_t port, uint8_t* dst);
+//     void out(uint16_t port, uint8_t value);
+// so each backend gets the sequence compiled against its own port primitives. in() stores
+// through a pointer so batching backends can queue the read and fill dst later.
+namespace ec_protocol {
+    const uint16_t SIO_INDEX_PORT = 0x4E;
+    const uint16_t SIO_DATA_PORT = 0x4F;
+
+    const uint8_t SIO_D2_INDEX = 0x2E;
+    const uint8_t SIO_D2_DATA = 0x2F;
+
+    const uint8_t D2_ADDR_LO = 0x10;
+    const uint8_t D2_ADDR_HI = 0x11;
+    const uint8_t D2_DATA = 0x12;
+
+    // One step of a port program, as executed by PortBackend::executePortProgram (and by
+    // winring_wrapper's ExecutePortProgram export behind it on Windows).
+    // Reads store their result in the next free slot of the caller's results buffer.
+    struct PortOp {
+        uint16_t port;
+        uint8_t value;   // Value to write (ignored for reads)
+        uint8_t is_read; // Nonzero for a read
+    };
+
+    template <typename Io>
+    inline void setD2Register(Io& io, uint8_t reg, uint8_t value) {
+        io.out(SIO_INDEX_PORT, SIO_D2_INDEX);
+        io.out(SIO_DATA_PORT, reg);
+        io.out(SIO_INDEX_PORT, SIO_D2_DATA);
+        io.out(SIO_DATA_PORT, value);
+    }
+
+    template <typename Io>
+    inline void selectD2Data(Io& io) {
+        io.out(SIO_INDEX_PORT, SIO_D2_INDEX);
+        io.out(SIO_DATA_PORT, D2_DATA);
+        io.out(SIO_INDEX_PORT, SIO_D2_DATA);
+    }
+
+    // Points the latch at addr. The high byte is only sent for the first byte of a range
+    // and when the range crosses into a new 256-byte page.
+    template <typename Io>
+    inline void selectAddress(Io& io, uint16_t addr, bool first) {
+        if (first || (addr & 0xFF) == 0) {
+            setD2Register(io, D2_ADDR_HI, static_cast<uint8_t>(addr >> 8));
+        }
+        setD2Register(io, D2_ADDR_LO, static_cast<uint8_t>(addr & 0xFF));
+        selectD2Data(io);
+    }
+
+    // Reads len bytes starting at addr. Leaves the latch on the last byte with the data
+    // register selected.
+    template <typename Io>
+    inline void readRange(Io& io, uint16_t addr, uint8_t* out, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            const uint16_t a = static_cast<uint16_t>(addr + i);
+            selectAddress(io, a, i == 0);
+            io.in(SIO_DATA_PORT, &out[i]);
+        }
+    }
+
+    // Writes len bytes starting at addr. Leaves the latch like readRange.
+    template <typename Io>
+    inline void writeRange(Io& io, uint16_t addr, const uint8_t* data, size_t len) {
+        for (size_t i = 0; i < len; ++i) {
+            const uint16_t a = static_cast<uint16_t>(addr + i);
+            selectAddress(io, a, i == 0);
+            io.out(SIO_DATA_PORT, data[i]);
+        }
+    }
+} // namespace ec_protocol
+
+#endif // EC_PROTOCOL_H
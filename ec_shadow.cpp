@@ -0,0 +1,182 @@
+#include "ec_shadow.h"
+#include <algorithm>
+
+EcShadowRam::EcShadowRam()
+    : bytes(SIZE, 0),
+      valid_bits(SIZE / 64, 0),
+      dirty_bits(SIZE / 64, 0),
+      line_time(LINES, Clock::time_point::min()),
+      line_region(LINES, 0) {
+    regions.push_back({ false, Clock::duration::zero() });
+}
+
+int EcShadowRam::addRegion(std::chrono::milliseconds maxAge) {
+    if (regions.size() > 0xFF) {
+        return 0; // line_region is a byte
+    }
+    regions.push_back({ false, Clock::duration::zero() });
+    const int region = static_cast<int>(regions.size() - 1);
+    setRegionMaxAge(region, maxAge);
+    return region;
+}
+
+void EcShadowRam::setRegionMaxAge(int region, std::chrono::milliseconds maxAge) {
+    if (region <= 0 || static_cast<size_t>(region) >= regions.size()) {
+        return; // Region 0 is fixed at zero age
+    }
+    Region& entry = regions[region];
+    entry.unbounded = maxAge == std::chrono::milliseconds::max();
+    entry.max_age = entry.unbounded ? Clock::duration::zero()
+                                    : std::chrono::duration_cast<Clock::duration>(maxAge);
+}
+
+void EcShadowRam::assignRegion(int region, uint16_t addr, size_t len) {
+    if (region < 0 || static_cast<size_t>(region) >= regions.size() || len == 0) {
+        return;
+    }
+    len = clampLen(addr, len);
+    const size_t first = addr / LINE_SIZE;
+    const size_t last = (addr + len - 1) / LINE_SIZE;
+    for (size_t line = first; line <= last; ++line) {
+        line_region[line] = static_cast<uint8_t>(region);
+    }
+}
+
+bool EcShadowRam::lineFresh(size_t line, Clock::time_point now) const {
+    const Region& region = regions[line_region[line]];
+    const Clock::time_point filled = line_time[line];
+    if (filled == Clock::time_point::min()) {
+        return false; // Expired or never filled
+    }
+    if (region.unbounded) {
+        return true;
+    }
+    return region.max_age > Clock::duration::zero() && now - filled <= region.max_age;
+}
+
+bool EcShadowRam::isFresh(uint16_t addr, size_t len, Clock::time_point now) const {
+    if (len == 0 || !isValid(addr, len)) {
+        return false;
+    }
+    len = clampLen(addr, len);
+    const size_t first = addr / LINE_SIZE;
+    const size_t last = (addr + len - 1) / LINE_SIZE;
+    for (size_t line = first; line <= last; ++line) {
+        if (!lineFresh(line, now)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool EcShadowRam::isValid(uint16_t addr, size_t len) const {
+    len = clampLen(addr, len);
+    for (size_t i = addr; i < addr + len; ++i) {
+        if (!testBit(valid_bits, i)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void EcShadowRam::copyOut(uint16_t addr, uint8_t* out, size_t len) const {
+    len = clampLen(addr, len);
+    for (size_t i = 0; i < len; ++i) {
+        out[i] = bytes[addr + i];
+    }
+}
+
+void EcShadowRam::fill(uint16_t addr, const uint8_t* data, size_t len, Clock::time_point now) {
+    len = clampLen(addr, len);
+    if (len == 0) {
+        return;
+    }
+    touchLines(addr, len, now);
+    for (size_t i = 0; i < len; ++i) {
+        const size_t a = addr + i;
+        if (testBit(dirty_bits, a)) {
+            continue; // A pending write wins over what the EC held before it
+        }
+        bytes[a] = data[i];
+        setBit(valid_bits, a);
+    }
+}
+
+bool EcShadowRam::stage(uint16_t addr, uint8_t value, bool force) {
+    if (!force && testBit(valid_bits, addr) && bytes[addr] == value) {
+        return false;
+    }
+    const size_t line = addr / LINE_SIZE;
+    bool line_has_valid = false;
+    for (size_t i = line * LINE_SIZE; i < (line + 1) * LINE_SIZE; ++i) {
+        if (i != addr && testBit(valid_bits, i)) {
+            line_has_valid = true;
+            break;
+        }
+    }
+    if (!line_has_valid) {
+        line_time[line] = Clock::now(); // Nothing older in the line; it is as fresh as this write
+    }
+
+    bytes[addr] = value;
+    setBit(valid_bits, addr);
+    if (!testBit(dirty_bits, addr)) {
+        setBit(dirty_bits, addr);
+        ++dirty_count;
+    }
+    return true;
+}
+
+void EcShadowRam::expire(uint16_t addr, size_t len) {
+    len = clampLen(addr, len);
+    if (len == 0) {
+        return;
+    }
+    const size_t first = addr / LINE_SIZE;
+    const size_t last = (addr + len - 1) / LINE_SIZE;
+    for (size_t line = first; line <= last; ++line) {
+        line_time[line] = Clock::time_point::min();
+    }
+}
+
+void EcShadowRam::invalidate(uint16_t addr, size_t len) {
+    len = clampLen(addr, len);
+    for (size_t i = addr; i < addr + len; ++i) {
+        clearBit(valid_bits, i);
+    }
+    clearDirtyRange(addr, addr + len);
+    expire(addr, len);
+}
+
+void EcShadowRam::invalidateAll() {
+    std::fill(valid_bits.begin(), valid_bits.end(), 0);
+    std::fill(dirty_bits.begin(), dirty_bits.end(), 0);
+    std::fill(line_time.begin(), line_time.end(), Clock::time_point::min());
+    dirty_count = 0;
+}
+
+void EcShadowRam::touchLines(uint16_t addr, size_t len, Clock::time_point now) {
+    const size_t begin = addr;
+    const size_t end = addr + len;
+    for (size_t line = begin / LINE_SIZE; line <= (end - 1) / LINE_SIZE; ++line) {
+        bool older_valid = false;
+        for (size_t i = line * LINE_SIZE; i < (line + 1) * LINE_SIZE; ++i) {
+            if ((i < begin || i >= end) && testBit(valid_bits, i)) {
+                older_valid = true;
+                break;
+            }
+        }
+        if (!older_valid) {
+            line_time[line] = now;
+        }
+    }
+}
+
+void EcShadowRam::clearDirtyRange(size_t begin, size_t end) {
+    for (size_t i = begin; i < end; ++i) {
+        if (testBit(dirty_bits, i)) {
+            clearBit(dirty_bits, i);
+            --dirty_count;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+#ifndef EC_SHADOW_H
+#define EC_SHADOW_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// In-process copy of the 64 KiB EC address space. Every byte has a valid bit (the shadow
+// holds what the EC holds) and a dirty bit (staged by a write, not sent yet).
+//
+// Freshness is tracked per 16-byte line: a line's timestamp is when its oldest valid byte was
+// last read from or written to the EC. Each line belongs to a region with its own maximum
+// age. Lines outside every region (region 0) have a maximum age of zero, so volatile
+// registers such as RPM counters are never served from the shadow.
+class EcShadowRam {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const size_t SIZE = 0x10000;
+    static const size_t LINE_SIZE = 16;
+
+    EcShadowRam();
+
+    // Creates a staleness region and returns its id (> 0), or 0 if the region table is full.
+    // milliseconds::max() means bytes never age out.
+    int addRegion(std::chrono::milliseconds maxAge);
+    void setRegionMaxAge(int region, std::chrono::milliseconds maxAge);
+
+    // Assigns the lines covering [addr, addr + len) to region. The range is widened to whole
+    // 16-byte lines.
+    void assignRegion(int region, uint16_t addr, size_t len);
+
+    // True if every byte of the range is valid and its line is within its region's max age
+    bool isFresh(uint16_t addr, size_t len, Clock::time_point now) const;
+
+    // True if every byte of the range is valid, regardless of age
+    bool isValid(uint16_t addr, size_t len) const;
+
+    // Copies shadow bytes out without any freshness check
+    void copyOut(uint16_t addr, uint8_t* out, size_t len) const;
+    uint8_t at(uint16_t addr) const { return bytes[addr]; }
+
+    // Records bytes just read from the EC. Dirty bytes keep their staged value.
+    void fill(uint16_t addr, const uint8_t* data, size_t len, Clock::time_point now);
+
+    // Stages a write. The byte is marked dirty if force is set or the shadow does not already
+    // hold value; returns whether it was. Staged bytes are valid at once, so a read right
+    // after a write needs no bus access.
+    bool stage(uint16_t addr, uint8_t value, bool force = false);
+
+    // Hands every maximal run of dirty bytes to writer(addr, data, len) in address order and
+    // clears the run's dirty bits once writer returns. If writer throws, the runs not written
+    // yet stay dirty. Stops after maxBytes (splitting a run if needed). Returns the number of
+    // bytes written.
+    template <typename Writer>
+    size_t flush(Writer&& writer, Clock::time_point now, size_t maxBytes = SIZE);
+
+    // Like flush, but only for the dirty bytes in [addr, addr + len); the rest stay dirty
+    template <typename Writer>
+    size_t flushRange(Writer&& writer, uint16_t addr, size_t len, Clock::time_point now, size_t maxBytes = SIZE);
+
+    // Marks the range stale so the next read goes to the EC. The bytes stay valid, so
+    // writes can still skip values the EC already holds.
+    void expire(uint16_t addr, size_t len);
+
+    // Forgets the range: clears valid and dirty bits
+    void invalidate(uint16_t addr, size_t len);
+    void invalidateAll();
+
+    size_t dirtyCount() const { return dirty_count; }
+
+private:
+    struct Region {
+        bool unbounded;
+        Clock::duration max_age;
+    };
+
+    static const size_t LINES = SIZE / LINE_SIZE;
+
+    std::vector<uint8_t> bytes;           // 64 KiB
+    std::vector<uint64_t> valid_bits;     // One bit per byte
+    std::vector<uint64_t> dirty_bits;     // One bit per byte
+    std::vector<Clock::time_point> line_time; // Per line; time_point::min() means expired
+    std::vector<uint8_t> line_region;     // Per line, index into regions
+    std::vector<Region> regions;          // regions[0]: never served
+    size_t dirty_count = 0;
+
+    static bool testBit(const std::vector<uint64_t>& bits, size_t i) {
+        return (bits[i >> 6] >> (i & 63)) & 1u;
+    }
+    static void setBit(std::vector<uint64_t>& bits, size_t i) { bits[i >> 6] |= uint64_t(1) << (i & 63); }
+    static void clearBit(std::vector<uint64_t>& bits, size_t i) { bits[i >> 6] &= ~(uint64_t(1) << (i & 63)); }
+
+    static size_t clampLen(uint16_t addr, size_t len) {
+        return (addr + len > SIZE) ? SIZE - addr : len;
+    }
+
+    bool lineFresh(size_t line, Clock::time_point now) const;
+
+    // Refreshes the timestamp of each line touched by [addr, addr + len) that has no valid
+    // bytes outside the range; otherwise the line keeps the age of its older bytes.
+    void touchLines(uint16_t addr, size_t len, Clock::time_point now);
+
+    void clearDirtyRange(size_t begin, size_t end);
+};
+
+template <typename Writer>
+size_t EcShadowRam::flush(Writer&& writer, Clock::time_point now, size_t maxBytes) {
+    return flushRange(writer, 0, SIZE, now, maxBytes);
+}
+
+template <typename Writer>
+size_t EcShadowRam::flushRange(Writer&& writer, uint16_t first, size_t len, Clock::time_point now, size_t maxBytes) {
+    const size_t last = first + clampLen(first, len);
+    size_t written = 0;
+    size_t addr = first;
+    while (dirty_count > 0 && addr < last && written < maxBytes) {
+        if ((addr & 63) == 0 && dirty_bits[addr >> 6] == 0) {
+            addr += 64; // Skip clean words
+            continue;
+        }
+        if (!testBit(dirty_bits, addr)) {
+            ++addr;
+            continue;
+        }
+        size_t end = addr + 1;
+        while (end < last && end - addr < maxBytes - written && testBit(dirty_bits, end)) {
+            ++end;
+        }
+        writer(static_cast<uint16_t>(addr), &bytes[addr], end - addr);
+        clearDirtyRange(addr, end);
+        touchLines(static_cast<uint16_t>(addr), end - addr, now);
+        written += end - addr;
+        addr = end;
+    }
+    return written;
+}
+
+#endif // EC_SHADOW_H
@@ -0,0 +1,160 @@
+#ifndef EC_WAIT_H
+#define EC_WAIT_H
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+
+// Spin/yield/sleep budgets for EcReadyWaiter
+struct EcWaitPolicy {
+    std::chrono::nanoseconds spin_budget{20000};   // Busy-poll without touching the scheduler
+    std::chrono::nanoseconds yield_budget{500000}; // Then poll with a thread yield in between
+    std::chrono::milliseconds timeout{50};          // Then poll with 1 ms sleeps up to here
+    bool ready_check = false; // Whether the backend waits at all; off unless the caller opts in
+};
+
+// Wait-time statistics. Bucket 0 counts waits under 1 us; bucket i counts waits in
+// [2^(i-1), 2^i) us; the last bucket takes everything longer.
+struct EcWaitHistogram {
+    static const size_t BUCKETS = 20;
+
+    uint64_t buckets[BUCKETS] = {};
+    uint64_t waits = 0;
+    uint64_t immediate = 0; // Ready on the first poll
+    uint64_t spun = 0;      // Became ready during the spin phase
+    uint64_t yielded = 0;   // ... during the yield phase
+    uint64_t slept = 0;     // ... during the sleep phase
+    uint64_t timeouts = 0;
+    uint64_t trips = 0;     // Circuit breaker openings (see EcReadyWaiter::tripped)
+    uint64_t max_wait_ns = 0;
+};
+
+// Waits for an EC ready condition (e.g. ACPI EC IBF clear on port 0x66) without paying a
+// fixed sleep per port op. Polls in three phases: a busy spin, then yields, then 1 ms
+// sleeps until the timeout. The spin phase is counted in polls instead of clock reads;
+// calibrate() measures how long one poll takes so the poll count matches spin_budget.
+// After BREAKER_TIMEOUTS timeouts in a row the waiter trips: the condition evidently does
+// not apply to this EC, and the caller should stop waiting instead of paying the full
+// timeout on every port op.
+// Header-only so winring_wrapper.cpp can use it without linking FanController code.
+class EcReadyWaiter {
+public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const uint32_t BREAKER_TIMEOUTS = 3;
+
+    void setPolicy(const EcWaitPolicy& newPolicy) {
+        policy = newPolicy;
+        updateSpinPolls();
+    }
+    const EcWaitPolicy& getPolicy() const { return policy; }
+
+    // Times a burst of polls of ready to derive the spin poll count. The result of ready is
+    // ignored. Called automatically on the first wait.
+    template <typename Ready>
+    void calibrate(Ready&& ready) {
+        const int CALIBRATION_POLLS = 64;
+        const Clock::time_point start = Clock::now();
+        for (int i = 0; i < CALIBRATION_POLLS; ++i) {
+            (void)ready();
+        }
+        const auto elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start);
+        poll_ns = elapsed.count() / CALIBRATION_POLLS;
+        if (poll_ns < 1) {
+            poll_ns = 1;
+        }
+        calibrated = true;
+        updateSpinPolls();
+    }
+
+    // Polls ready() until it returns true or the policy timeout passes. Returns false on timeout.
+    template <typename Ready>
+    bool wait(Ready&& ready) {
+        ++stats.waits;
+        if (ready()) {
+            ++stats.immediate;
+            record(0);
+            consecutive_timeouts = 0;
+            return true;
+        }
+        if (!calibrated) {
+            calibrate(ready);
+        }
+
+        const Clock::time_point start = Clock::now();
+        for (uint64_t i = 0; i < spin_polls; ++i) {
+            if (ready()) {
+                ++stats.spun;
+                record(elapsedNs(start));
+                consecutive_timeouts = 0;
+                return true;
+            }
+        }
+
+        const Clock::time_point yield_end = start + policy.spin_budget + policy.yield_budget;
+        while (Clock::now() < yield_end) {
+            std::this_thread::yield();
+            if (ready()) {
+                ++stats.yielded;
+                record(elapsedNs(start));
+                consecutive_timeouts = 0;
+                return true;
+            }
+        }
+
+        const Clock::time_point deadline = start + policy.timeout;
+        while (Clock::now() < deadline) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            if (ready()) {
+                ++stats.slept;
+                record(elapsedNs(start));
+                consecutive_timeouts = 0;
+                return true;
+            }
+        }
+
+        ++stats.timeouts;
+        record(elapsedNs(start));
+        if (++consecutive_timeouts == BREAKER_TIMEOUTS) {
+            ++stats.trips;
+        }
+        return false;
+    }
+
+    // True once BREAKER_TIMEOUTS waits in a row timed out; rearm() clears it
+    bool tripped() const { return consecutive_timeouts >= BREAKER_TIMEOUTS; }
+    void rearm() { consecutive_timeouts = 0; }
+
+    const EcWaitHistogram& histogram() const { return stats; }
+    void resetHistogram() { stats = EcWaitHistogram(); }
+
+private:
+    EcWaitPolicy policy;
+    EcWaitHistogram stats;
+    bool calibrated = false;
+    uint32_t consecutive_timeouts = 0;
+    int64_t poll_ns = 1000; // Until calibrated: roughly one driver port read
+    uint64_t spin_polls = 20;
+
+    void updateSpinPolls() {
+        spin_polls = static_cast<uint64_t>(policy.spin_budget.count() / poll_ns);
+    }
+
+    static uint64_t elapsedNs(Clock::time_point start) {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - start).count());
+    }
+
+    void record(uint64_t ns) {
+        size_t bucket = 0;
+        for (uint64_t us = ns / 1000; us > 0 && bucket < EcWaitHistogram::BUCKETS - 1; us >>= 1) {
+            ++bucket;
+        }
+        ++stats.buckets[bucket];
+        if (ns > stats.max_wait_ns) {
+            stats.max_wait_ns = ns;
+        }
+    }
+};
+
+#endif // EC_WAIT_H
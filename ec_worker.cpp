@@ -0,0 +1,380 @@
+#include "ec_worker.h"
+#include <algorithm>
+
+
+EcWorker::EcWorker() {}
+
+EcWorker::EcWorker(std::unique_ptr<PortBackend> portBackend) : controller(std::move(portBackend)) {}
+
+EcWorker::~EcWorker() {
+    stop();
+}
+
+void EcWorker::start() {
+    if (running.exchange(true)) {
+        return; // Already running
+    }
+    thread = std::thread(&EcWorker::run, this);
+}
+
+void EcWorker::stop() {
+    if (!running.exchange(false)) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake_cv.notify_one();
+    if (thread.joinable()) {
+        thread.join();
+    }
+    controller.deinitialize();
+    initialized = false;
+}
+
+bool EcWorker::submit(EcCommand& command) {
+    command.submitted = Clock::now();
+    if (!commands.push(command)) {
+        return false;
+    }
+    {
+        // Taking the mutex orders the push before the worker's predicate check
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake_cv.notify_one();
+    return true;
+}
+
+bool EcWorker::submitApply(const FanConfigData& config, EcPriority priority, EcDeadline deadline, VerifyMode verify) {
+    EcCommand command;
+    command.type = EcCommandType::ApplyConfig;
+    command.priority = priority;
+    command.deadline = deadline;
+    command.config = config;
+    command.verify = verify;
+    return submit(command);
+}
+
+bool EcWorker::submitReload(EcPriority priority, EcDeadline deadline) {
+    EcCommand command;
+    command.type = EcCommandType::ReloadConfig;
+    command.priority = priority;
+    command.deadline = deadline;
+    return submit(command);
+}
+
+bool EcWorker::submitLiveEdit(const FanConfigData& config, const ConfigEntryMask& entries,
+                              EcPriority priority, EcDeadline deadline) {
+    EcCommand command;
+    command.type = EcCommandType::LiveEdit;
+    command.priority = priority;
+    command.deadline = deadline;
+    command.config = config;
+    command.entries = entries;
+    return submit(command);
+}
+
+bool EcWorker::latestSnapshot(EcStatusSnapshot& out) {
+    if (!snapshots.update()) {
+        return false;
+    }
+    out = snapshots.front();
+    return true;
+}
+
+bool EcWorker::pollResult(EcCommandResult& out) {
+    return results.pop(out);
+}
+
+bool EcWorker::isInitialized() const {
+    return initialized.load(std::memory_order_acquire);
+}
+
+void EcWorker::setPollInterval(std::chrono::milliseconds interval) {
+    poll_interval_ms.store(interval.count(), std::memory_order_relaxed);
+    poll_interval_changed.store(true, std::memory_order_release);
+    {
+        std::lock_guard<std::mutex> lock(wake_mutex);
+    }
+    wake_cv.notify_one(); // A shorter interval must not wait out a sleep sized for the old one
+}
+
+void EcWorker::setNotifier(std::function<void()> callback) {
+    notify = std::move(callback);
+}
+
+// --- Worker Thread ---
+
+void EcWorker::run() {
+    // Initialize on this thread so every EC access happens here
+    initializeController();
+
+    jobs.reserve(QUEUE_DEPTH + 1);
+    next_poll = Clock::now();
+    while (running.load(std::memory_order_acquire)) {
+        const Clock::time_point now = Clock::now();
+        while (commands.pop(pending)) {
+            enqueue(pending);
+        }
+        if (poll_interval_changed.exchange(false, std::memory_order_acq_rel)) {
+            next_poll = std::min(next_poll, now + std::chrono::milliseconds(poll_interval_ms.load(std::memory_order_relaxed)));
+        }
+
+        if (initialized.load(std::memory_order_relaxed) && !poll_queued && now >= next_poll) {
+            // The poll must finish before the next one is due
+            EcCommand poll;
+            poll.type = EcCommandType::Poll;
+            poll.priority = EcPriority::Control;
+            poll.deadline = next_poll + std::chrono::milliseconds(poll_interval_ms.load(std::memory_order_relaxed));
+            poll.submitted = next_poll;
+            enqueue(poll);
+            poll_queued = true;
+
+            // Checked at the poll rate, so a failing EC is not retried any faster than polls
+            const bool reload_queued = std::any_of(jobs.begin(), jobs.end(), [](const EcJob& j) {
+                return j.command.type == EcCommandType::ReloadConfig;
+            });
+            if (!refresh_queued && !reload_queued && controller.configRefreshDue()) {
+                EcCommand refresh;
+                refresh.type = EcCommandType::ConfigRefresh;
+                refresh.priority = EcPriority::Bulk;
+                refresh.submitted = now;
+                enqueue(refresh);
+                refresh_queued = true;
+            }
+        }
+
+        if (!jobs.empty()) {
+            // One chunk, then re-pick so newly arrived urgent requests get in
+            EcJob& job = jobs[pickJob()];
+            if (runStep(job)) {
+                job.cancelled = true;
+            }
+            jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const EcJob& j) { return j.cancelled; }), jobs.end());
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(wake_mutex);
+        const auto woken = [this] {
+            return !running.load(std::memory_order_acquire) || !commands.empty() ||
+                   poll_interval_changed.load(std::memory_order_acquire);
+        };
+        if (initialized.load(std::memory_order_relaxed)) {
+            wake_cv.wait_until(lock, next_poll, woken);
+        } else {
+            wake_cv.wait(lock, woken); // Nothing to poll; next_poll never advances
+        }
+    }
+}
+
+void EcWorker::initializeController() {
+    result = EcCommandResult();
+    result.type = EcCommandType::Initialize;
+    controller.setConsistentReads(true); // Snapshots feed the plots; no torn RPM values
+    if (!controller.initialize()) {
+        result.error = "Failed to initialize Fan Controller: " + controller.getLastError();
+    } else {
+        initialized.store(true, std::memory_order_release);
+        result.ok = controller.readStatus(result.status);
+        if (!result.ok) {
+            result.error = controller.getLastError();
+        }
+    }
+    postResult();
+}
+
+void EcWorker::enqueue(const EcCommand& command) {
+    EcJob job;
+    job.command = command;
+    job.seq = next_seq++;
+    if (command.type == EcCommandType::ReloadConfig && refresh_queued) {
+        // The reload re-reads everything, and both share the controller's slice pass
+        jobs.erase(std::remove_if(jobs.begin(), jobs.end(), [](const EcJob& j) {
+            return j.command.type == EcCommandType::ConfigRefresh;
+        }), jobs.end());
+        refresh_queued = false;
+    }
+    if (command.type == EcCommandType::ApplyConfig || command.type == EcCommandType::LiveEdit) {
+        forwardNewerEntries(job);
+    }
+    jobs.push_back(job);
+}
+
+// Highest priority class first, then earliest deadline, then oldest
+size_t EcWorker::pickJob() const {
+    size_t best = 0;
+    for (size_t i = 1; i < jobs.size(); ++i) {
+        const EcJob& a = jobs[i];
+        const EcJob& b = jobs[best];
+        if (a.command.priority != b.command.priority) {
+            if (a.command.priority < b.command.priority) best = i;
+        } else if (a.command.deadline != b.command.deadline) {
+            if (a.command.deadline < b.command.deadline) best = i;
+        } else if (a.seq < b.seq) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Runs the next chunk of job. Returns true once the job is finished and reported.
+bool EcWorker::runStep(EcJob& job) {
+    switch (job.command.type) {
+    case EcCommandType::Poll: {
+        EcStatusSnapshot& snapshot = snapshots.back();
+        snapshot.ok = controller.pollStatus(snapshot.status);
+        snapshot.poll_count = ++poll_count;
+        snapshot.error = snapshot.ok ? std::string() : controller.getLastError();
+
+        const Clock::time_point now = Clock::now();
+        snapshot.poll_latency = std::chrono::duration_cast<std::chrono::microseconds>(now - job.command.submitted);
+        snapshot.deadline_missed = now > job.command.deadline;
+        if (snapshot.deadline_missed) {
+            ++missed_deadlines;
+        }
+        snapshot.missed_deadlines = missed_deadlines;
+        snapshots.publish();
+        if (notify) {
+            notify();
+        }
+
+        next_poll = now + std::chrono::milliseconds(poll_interval_ms.load(std::memory_order_relaxed));
+        poll_queued = false;
+        return true;
+    }
+
+    case EcCommandType::ApplyConfig: {
+        if (job.step++ == 0) {
+            supersedeApplies(job.seq);
+            if (!controller.beginConfigWrite(job.command.config)) {
+                result = EcCommandResult();
+                finishJob(job, false, controller.getLastError());
+                return true;
+            }
+            return false;
+        }
+        if (!job.flushed) {
+            if (!controller.continueConfigWrite(CONFIG_CHUNK_BYTES, job.flushed)) {
+                result = EcCommandResult();
+                finishJob(job, false, controller.getLastError());
+                return true;
+            }
+            return false;
+        }
+        result = EcCommandResult();
+        const bool ok = controller.finishConfigWrite(job.command.config, job.command.verify, result.verify);
+        result.bytes_written = controller.getLastConfigBytesWritten();
+        finishJob(job, ok, controller.getLastError());
+        return true;
+    }
+
+    case EcCommandType::ReloadConfig: {
+        if (job.step++ == 0) {
+            controller.invalidateConfigCache(); // An explicit reload always goes to the EC
+            controller.restartStatusRefresh();
+        }
+        bool complete = false;
+        if (!controller.refreshStatusSlice(job.status, RELOAD_SLICE_BUDGET, complete)) {
+            result = EcCommandResult();
+            finishJob(job, false, controller.getLastError());
+            return true;
+        }
+        if (!complete) {
+            return false;
+        }
+        result = EcCommandResult();
+        result.status = job.status;
+        finishJob(job, true, std::string());
+        return true;
+    }
+
+    case EcCommandType::ConfigRefresh: {
+        if (job.step++ == 0) {
+            controller.restartStatusRefresh();
+        }
+        bool complete = false;
+        const bool ok = controller.refreshStatusSlice(job.status, RELOAD_SLICE_BUDGET, complete, STATUS_CONFIG);
+        if (ok && !complete) {
+            return false;
+        }
+        // No result: the next poll serves the re-read values from the shadow, and a failure
+        // shows up there too
+        refresh_queued = false;
+        return true;
+    }
+
+    case EcCommandType::LiveEdit: {
+        result = EcCommandResult();
+        const bool ok = controller.writeConfigEntries(job.command.config, job.command.entries, result.bytes_written);
+        finishJob(job, ok, ok ? std::string() : controller.getLastError());
+        return true;
+    }
+
+    case EcCommandType::Initialize:
+        break; // Handled by initializeController
+    }
+    return true;
+}
+
+// Priority can run a newer write before an older one that touches the same entries (a live
+// edit between the chunks of an apply, or an emergency apply ahead of a pending live edit).
+// Copying the newer values into the older pending writes keeps the EC at whatever was
+// submitted last. An older apply is left to supersedeApplies instead: bytes it already
+// staged would no longer match the values it verifies against.
+void EcWorker::forwardNewerEntries(const EcJob& newer) {
+    ConfigEntryMask entries = newer.command.entries;
+    if (newer.command.type == EcCommandType::ApplyConfig) {
+        for (uint16_t& mask : entries.tables) {
+            mask = static_cast<uint16_t>((1u << EcTable().size()) - 1);
+        }
+    }
+    for (EcJob& older : jobs) {
+        if (older.cancelled) {
+            continue;
+        }
+        const bool olderLive = older.command.type == EcCommandType::LiveEdit;
+        const bool olderApply = older.command.type == EcCommandType::ApplyConfig;
+        if (olderLive || (olderApply && newer.command.type == EcCommandType::LiveEdit)) {
+            copyConfigEntries(newer.command.config, entries, older.command.config);
+        }
+    }
+}
+
+// Cancels applies submitted before seq. Their pending bytes are either already sent or
+// restaged by the newer apply, which must not be overwritten by an older one afterwards.
+void EcWorker::supersedeApplies(uint64_t seq) {
+    for (EcJob& other : jobs) {
+        if (other.command.type == EcCommandType::ApplyConfig && other.seq < seq && !other.cancelled) {
+            result = EcCommandResult();
+            finishJob(other, false, "Superseded by a newer apply request.");
+            other.cancelled = true;
+        }
+    }
+}
+
+// Fills in the common result fields (on top of whatever the step left in result) and posts it
+void EcWorker::finishJob(const EcJob& job, bool ok, const std::string& error) {
+    const Clock::time_point now = Clock::now();
+    result.type = job.command.type;
+    result.ok = ok;
+    result.error = error;
+    result.latency = std::chrono::duration_cast<std::chrono::microseconds>(now - job.command.submitted);
+    result.deadline_missed = now > job.command.deadline;
+    if (result.deadline_missed) {
+        ++missed_deadlines;
+    }
+    postResult();
+}
+
+void EcWorker::postResult() {
+    // The GUI drains results every frame; wait for room rather than dropping a completion
+    while (!results.push(result)) {
+        if (!running.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    if (notify) {
+        notify();
+    }
+}
@@ -0,0 +1,252 @@
+#ifndef EC_WORKER_H
+#define EC_WORKER_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "fan_control.h"
+
+// Bounded single-producer/single-consumer queue. push() fails instead of blocking when full.
+// Slots are preallocated and copy-assigned, so push/pop never allocate for trivially copyable
+// payloads such as FanConfigData.
+template <typename T, size_t Capacity>
+class SpscQueue {
+public:
+    bool push(const T& item) {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % SLOTS;
+        if (next == head_.load(std::memory_order_acquire)) {
+            return false; // Full
+        }
+        slots_[tail] = item;
+        tail_.store(next, std::memory_order_release);
+        return true;
+    }
+
+    bool pop(T& out) {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tail_.load(std::memory_order_acquire)) {
+            return false; // Empty
+        }
+        out = slots_[head];
+        head_.store((head + 1) % SLOTS, std::memory_order_release);
+        return true;
+    }
+
+    bool empty() const {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static const size_t SLOTS = Capacity + 1; // One slot stays empty to tell full from empty
+    std::array<T, SLOTS> slots_;
+    std::atomic<size_t> head_{0}; // Consumer-owned
+    std::atomic<size_t> tail_{0}; // Producer-owned
+};
+
+// Lock-free triple buffer for publishing snapshots from one writer thread to one reader.
+// The writer fills back() and calls publish(); the reader calls update() and then reads
+// front(). Neither side ever waits, and the reader always sees a complete snapshot.
+template <typename T>
+class SnapshotBuffer {
+public:
+    // Writer side
+    T& back() { return slots_[back_]; }
+
+    void publish() {
+        const uint8_t prev = middle_.exchange(static_cast<uint8_t>(back_ | FRESH), std::memory_order_acq_rel);
+        back_ = prev & INDEX_MASK;
+    }
+
+    // Reader side. Returns true if a newer snapshot was swapped into front().
+    bool update() {
+        if (!(middle_.load(std::memory_order_acquire) & FRESH)) {
+            return false;
+        }
+        const uint8_t prev = middle_.exchange(front_, std::memory_order_acq_rel);
+        front_ = prev & INDEX_MASK;
+        return true;
+    }
+
+    const T& front() const { return slots_[front_]; }
+
+private:
+    static const uint8_t INDEX_MASK = 0x3;
+    static const uint8_t FRESH = 0x4;
+
+    T slots_[3];
+    std::atomic<uint8_t> middle_{1};
+    uint8_t back_ = 0;  // Writer-owned
+    uint8_t front_ = 2; // Reader-owned
+};
+
+// Requests the GUI can hand to the worker thread
+enum class EcCommandType {
+    Initialize,   // Issued by the worker itself on start; only ever seen in results
+    ApplyConfig,  // writeConfig with read-back verification
+    ReloadConfig, // Full readStatus that bypasses the EC shadow
+    Poll,         // Periodic pollStatus, scheduled by the worker itself; never seen in results
+    LiveEdit,     // writeConfigEntries for a few table entries, no verification
+    ConfigRefresh // Drift re-read of the static registers, scheduled by the worker itself; never seen in results
+};
+
+// Scheduling class of a request. Lower classes run first; within a class the earlier
+// deadline wins, then the earlier submission. Large requests run in chunks, so a
+// higher-class request waits for at most one chunk of a lower one.
+enum class EcPriority {
+    Emergency, // E.g. a max-fan config that must not wait behind anything
+    Control,   // Control-loop reads (the periodic telemetry poll)
+    Bulk       // Config applies, full reloads and drift re-reads
+};
+
+typedef std::chrono::steady_clock::time_point EcDeadline;
+const EcDeadline EC_NO_DEADLINE = EcDeadline::max();
+
+struct EcCommand {
+    EcCommandType type = EcCommandType::ReloadConfig;
+    EcPriority priority = EcPriority::Bulk;
+    EcDeadline deadline = EC_NO_DEADLINE;
+    std::chrono::steady_clock::time_point submitted; // Set by the worker on submit
+    FanConfigData config;    // ApplyConfig, LiveEdit
+    ConfigEntryMask entries; // LiveEdit: the entries of config to send
+    VerifyMode verify = VerifyMode::WrittenBytes; // ApplyConfig: read-back after the write
+};
+
+// Completion notice for a command, returned to the GUI
+struct EcCommandResult {
+    EcCommandType type = EcCommandType::ReloadConfig;
+    bool ok = false;
+    FanStatusData status;          // Full status (Initialize, ReloadConfig)
+    ConfigVerifyResult verify;     // ApplyConfig
+    size_t bytes_written = 0;      // ApplyConfig, LiveEdit
+    bool deadline_missed = false;  // Completed after the request's deadline
+    std::chrono::microseconds latency{0}; // Submission to completion
+    std::string error;
+};
+
+// Snapshot published after every background poll
+struct EcStatusSnapshot {
+    FanStatusData status;
+    bool ok = false;
+    uint64_t poll_count = 0;
+    bool deadline_missed = false;           // This poll finished after the next one was due
+    std::chrono::microseconds poll_latency{0}; // Due time to completion
+    uint64_t missed_deadlines = 0;          // Requests and polls that missed their deadline since start
+    std::string error;
+};
+
+// Owns the FanController and runs all EC I/O on a dedicated thread, so the render loop
+// never blocks on port access. Status is published through a SnapshotBuffer; apply/reload
+// requests and their results travel through bounded SPSC queues.
+//
+// Requests, including the worker's own periodic poll, are scheduled by priority and deadline.
+// Applies run as a staging step, CONFIG_CHUNK_BYTES-sized write slices and a finishing step;
+// reloads run as refreshStatusSlice slices of about RELOAD_SLICE_BUDGET each. The periodic
+// poll only samples telemetry; when the shadowed config goes stale (configRefreshDue) the
+// worker queues a Bulk ConfigRefresh that re-reads it in the same slices. The scheduler
+// picks again after every chunk, and newer applies supersede older ones that have not finished.
+// Writes keep submission order per entry: a newer apply or live edit copies its values into
+// older pending writes, so one that runs later cannot put back an older value.
+class EcWorker {
+public:
+    EcWorker();
+    // Runs the controller on the given port backend, e.g. SimulatedEcPortBackend
+    explicit EcWorker(std::unique_ptr<PortBackend> portBackend);
+    ~EcWorker();
+
+    // Starts the thread, which initializes the controller and loads the initial status
+    void start();
+
+    // Stops the thread and deinitializes the controller
+    void stop();
+
+    // Queues a command. Returns false if the queue is full. An apply only sends the bytes that
+    // differ from the EC shadow, so bytes already sent by live edits are neither written nor, with
+    // VerifyMode::WrittenBytes, read back; pass AllTables to verify those too.
+    bool submitApply(const FanConfigData& config, EcPriority priority = EcPriority::Bulk,
+                     EcDeadline deadline = EC_NO_DEADLINE, VerifyMode verify = VerifyMode::WrittenBytes);
+    bool submitReload(EcPriority priority = EcPriority::Bulk, EcDeadline deadline = EC_NO_DEADLINE);
+    // Sends just the selected entries of config (curve editing while dragging). Runs as one
+    // step at Control priority by default so it lands between the chunks of a bulk apply.
+    bool submitLiveEdit(const FanConfigData& config, const ConfigEntryMask& entries,
+                        EcPriority priority = EcPriority::Control, EcDeadline deadline = EC_NO_DEADLINE);
+
+    // Copies the newest status snapshot into out. Returns false if nothing new was published.
+    bool latestSnapshot(EcStatusSnapshot& out);
+
+    // Pops one finished command result. Returns false if none is waiting.
+    bool pollResult(EcCommandResult& out);
+
+    bool isInitialized() const;
+
+    void setPollInterval(std::chrono::milliseconds interval);
+
+    // Called on the worker thread after each snapshot is published and each result is
+    // posted, so an event-driven GUI can sleep until there is something new. Set before start().
+    void setNotifier(std::function<void()> callback);
+
+private:
+    static const size_t QUEUE_DEPTH = 8;
+    static const size_t CONFIG_CHUNK_BYTES = 20; // Two tables, ~160 port ops per slice
+    static constexpr std::chrono::microseconds RELOAD_SLICE_BUDGET{1000};
+
+    typedef std::chrono::steady_clock Clock;
+
+    // A request being scheduled, possibly part-way through its chunks
+    struct EcJob {
+        EcCommand command;
+        uint64_t seq = 0;
+        size_t step = 0;        // Chunks run so far
+        bool flushed = false;   // ApplyConfig: all table bytes sent
+        bool cancelled = false; // Already reported; removed after the current step
+        FanStatusData status;   // ReloadConfig: filled when the last slice completes
+    };
+
+    FanController controller;
+    std::thread thread;
+    std::atomic<bool> running{false};
+    std::atomic<bool> initialized{false};
+    std::atomic<int64_t> poll_interval_ms{100};
+    std::atomic<bool> poll_interval_changed{false};
+    std::function<void()> notify;
+
+    SpscQueue<EcCommand, QUEUE_DEPTH> commands;
+    SpscQueue<EcCommandResult, QUEUE_DEPTH> results;
+    SnapshotBuffer<EcStatusSnapshot> snapshots;
+    uint64_t poll_count = 0;
+
+    // Only used to sleep between polls and wake up early on new commands
+    std::mutex wake_mutex;
+    std::condition_variable wake_cv;
+
+    // Worker-thread state
+    std::vector<EcJob> jobs;
+    uint64_t next_seq = 0;
+    uint64_t missed_deadlines = 0;
+    Clock::time_point next_poll;
+    bool poll_queued = false;
+    bool refresh_queued = false;
+    EcCommand pending;
+    EcCommandResult result; // Scratch, reused across commands
+
+    bool submit(EcCommand& command);
+    void run();
+    void initializeController();
+    void enqueue(const EcCommand& command);
+    size_t pickJob() const;
+    bool runStep(EcJob& job);
+    void forwardNewerEntries(const EcJob& newer);
+    void supersedeApplies(uint64_t seq);
+    void finishJob(const EcJob& job, bool ok, const std::string& error);
+    void postResult();
+};
+
+#endif // EC_WORKER_H
@@ -0,0 +1,146 @@
+#include "editable_config.h"
+#include <algorithm>
+
+namespace {
+    struct FieldInfo {
+        const char* name;
+        EcTable FanConfigData::*config;
+        EcTable FanStatusData::*status;
+    };
+
+    // Indexed by EditableConfig::Field
+    const FieldInfo FIELDS[EditableConfig::FIELD_COUNT] = {
+        { "fan1_curve", &FanConfigData::fan1_curve, &FanStatusData::fan1_curve },
+        { "fan2_curve", &FanConfigData::fan2_curve, &FanStatusData::fan2_curve },
+        { "acc_time", &FanConfigData::acc_time, &FanStatusData::acc_time },
+        { "dec_time", &FanConfigData::dec_time, &FanStatusData::dec_time },
+        { "cpu_lower_temp", &FanConfigData::cpu_lower_temp, &FanStatusData::cpu_lower_temp },
+        { "cpu_upper_temp", &FanConfigData::cpu_upper_temp, &FanStatusData::cpu_upper_temp },
+        { "gpu_lower_temp", &FanConfigData::gpu_lower_temp, &FanStatusData::gpu_lower_temp },
+        { "gpu_upper_temp", &FanConfigData::gpu_upper_temp, &FanStatusData::gpu_upper_temp },
+        { "vrm_lower_temp", &FanConfigData::vrm_lower_temp, &FanStatusData::vrm_lower_temp },
+        { "vrm_upper_temp", &FanConfigData::vrm_upper_temp, &FanStatusData::vrm_upper_temp },
+    };
+
+    // Tables behind each curve view
+    struct CurveFields {
+        EditableConfig::Field curve;
+        EditableConfig::Field upper;
+        EditableConfig::Field lower;
+    };
+    const CurveFields CURVE_FIELDS[2] = {
+        { EditableConfig::FAN1_CURVE, EditableConfig::CPU_UPPER_TEMP, EditableConfig::CPU_LOWER_TEMP },
+        { EditableConfig::FAN2_CURVE, EditableConfig::GPU_UPPER_TEMP, EditableConfig::GPU_LOWER_TEMP },
+    };
+
+    const int LOWER_TEMP_GAP = 3; // Next point's lower temp sits this far below the upper temp
+} // end anonymous namespace
+
+EditableConfig::EditableConfig() {
+    load(FanConfigData());
+}
+
+void EditableConfig::load(const FanConfigData& newConfig) {
+    config = newConfig;
+    clearDirty();
+    rebuildCurve(0);
+    rebuildCurve(1);
+}
+
+void EditableConfig::loadFromStatus(const FanStatusData& status) {
+    for (const FieldInfo& field : FIELDS) {
+        config.*field.config = status.*field.status;
+    }
+    clearDirty();
+    rebuildCurve(0);
+    rebuildCurve(1);
+}
+
+EcTable& EditableConfig::table(Field field) {
+    return config.*FIELDS[field].config;
+}
+
+const EcTable& EditableConfig::table(Field field) const {
+    return config.*FIELDS[field].config;
+}
+
+bool EditableConfig::set(Field field, size_t index, int value) {
+    EcTable& entries = table(field);
+    if (index >= entries.size()) {
+        return false;
+    }
+    const uint8_t byte = static_cast<uint8_t>(std::max(0, std::min(255, value)));
+    if (entries[index] == byte) {
+        return false;
+    }
+    entries[index] = byte;
+    dirty.tables[field] |= static_cast<DirtyMask>(1u << index);
+    return true;
+}
+
+void EditableConfig::rebuildCurve(int fan) {
+    const CurveFields& fields = CURVE_FIELDS[fan];
+    const EcTable& temps = table(fields.upper);
+    const EcTable& values = table(fields.curve);
+    curves[fan].assign(temps.data(), values.data(), temps.size());
+}
+
+void EditableConfig::moveCurvePoint(int fan, size_t id, int temp, int rpm, size_t& firstRank, size_t& lastRank) {
+    const CurveFields& fields = CURVE_FIELDS[fan];
+    set(fields.upper, id, temp);
+    set(fields.curve, id, rpm / 100); // The EC stores 0-100
+    if (id + 1 < table(fields.lower).size()) {
+        set(fields.lower, id + 1, std::max(0, temp - LOWER_TEMP_GAP));
+    }
+    // The view shows what will be written, so the RPM snaps to whole curve steps
+    curves[fan].move(id, get(fields.upper, id), get(fields.curve, id) * 100, firstRank, lastRank);
+}
+
+void EditableConfig::curvePointEntries(int fan, size_t id, ConfigEntryMask& entries) const {
+    const CurveFields& fields = CURVE_FIELDS[fan];
+    entries.tables[fields.upper] |= static_cast<DirtyMask>(1u << id);
+    entries.tables[fields.curve] |= static_cast<DirtyMask>(1u << id);
+    if (id + 1 < table(fields.lower).size()) {
+        entries.tables[fields.lower] |= static_cast<DirtyMask>(1u << (id + 1));
+    }
+}
+
+bool EditableConfig::isDirty() const {
+    for (DirtyMask mask : dirty.tables) {
+        if (mask != 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t EditableConfig::dirtyCount() const {
+    size_t count = 0;
+    for (DirtyMask mask : dirty.tables) {
+        for (; mask != 0; mask &= mask - 1) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void EditableConfig::clearDirty() {
+    dirty = ConfigEntryMask();
+}
+
+void EditableConfig::markDirty(const ConfigEntryMask& masks) {
+    for (size_t f = 0; f < FIELD_COUNT; ++f) {
+        dirty.tables[f] |= masks.tables[f];
+    }
+}
+
+void EditableConfig::takeDirty(ConfigEntryMask& masks) {
+    for (size_t f = 0; f < FIELD_COUNT; ++f) {
+        masks.tables[f] |= dirty.tables[f];
+    }
+    clearDirty();
+}
+
+const char* EditableConfig::fieldName(Field field) {
+    return FIELDS[field].name;
+}
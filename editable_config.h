@@ -0,0 +1,84 @@
+#ifndef EDITABLE_CONFIG_H
+#define EDITABLE_CONFIG_H
+
+#include <cstddef>
+#include <cstdint>
+#include "fan_control.h"
+#include "curve_points.h"
+
+// The GUI's editable copy of the fan config: one FanConfigData holding the bytes the EC will
+// get, per-byte dirty bits, and the two curve plots as views over it. Widgets and plots edit
+// through set()/moveCurvePoint(), which clamp to a byte, skip no-op writes and mark only the
+// bytes that changed, so Apply needs no conversion and the dirty set names exactly what changed.
+class EditableConfig {
+public:
+    // The ten tables, in FanConfigData member order (the ConfigEntryMask table order)
+    enum Field {
+        FAN1_CURVE,
+        FAN2_CURVE,
+        ACC_TIME,
+        DEC_TIME,
+        CPU_LOWER_TEMP,
+        CPU_UPPER_TEMP,
+        GPU_LOWER_TEMP,
+        GPU_UPPER_TEMP,
+        VRM_LOWER_TEMP,
+        VRM_UPPER_TEMP,
+        FIELD_COUNT
+    };
+
+    // One bit per table entry
+    typedef uint16_t DirtyMask;
+    static_assert(FIELD_COUNT == ConfigEntryMask::TABLES, "Field must index ConfigEntryMask tables");
+
+    EditableConfig();
+
+    // Replaces the whole config (e.g. after a reload) and clears every dirty bit
+    void load(const FanConfigData& config);
+    void loadFromStatus(const FanStatusData& status);
+
+    const FanConfigData& data() const { return config; }
+
+    uint8_t get(Field field, size_t index) const { return table(field)[index]; }
+
+    // Sets one entry, clamped to 0-255. Returns true (and marks it dirty) if the value changed.
+    bool set(Field field, size_t index, int value);
+
+    // Curve view for fan 0 (fan 1, CPU temps) or fan 1 (fan 2, GPU temps). Plot RPM is the
+    // curve value * 100.
+    const CurvePoints& curve(int fan) const { return curves[fan]; }
+
+    // Moves curve point id of fan to (temp, rpm): sets the point's upper temp and curve value
+    // and the next point's lower temp (temp - 3), keeping the curve view sorted.
+    // [firstRank, lastRank] are the sorted positions whose plot vertex changed.
+    void moveCurvePoint(int fan, size_t id, int temp, int rpm, size_t& firstRank, size_t& lastRank);
+
+    // Adds the entries moveCurvePoint(fan, id, ...) writes to entries
+    void curvePointEntries(int fan, size_t id, ConfigEntryMask& entries) const;
+
+    // Dirty set: bytes changed since load() or clearDirty()
+    bool isDirty() const;
+    DirtyMask dirtyMask(Field field) const { return dirty.tables[field]; }
+    const ConfigEntryMask& dirtyEntries() const { return dirty; }
+    size_t dirtyCount() const;
+    void clearDirty();
+
+    // Moves the dirty bits into masks (OR-ed in) and clears them, e.g. when handing the
+    // config to an apply. markDirty puts them back if that apply fails.
+    void takeDirty(ConfigEntryMask& masks);
+    void markDirty(const ConfigEntryMask& masks);
+
+    // FanConfigData member name of field, e.g. "fan1_curve"
+    static const char* fieldName(Field field);
+
+private:
+    FanConfigData config;
+    ConfigEntryMask dirty;
+    CurvePoints curves[2];
+
+    EcTable& table(Field field);
+    const EcTable& table(Field field) const;
+    void rebuildCurve(int fan);
+};
+
+#endif // EDITABLE_CONFIG_H
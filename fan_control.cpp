@@ -1,5 +1,4 @@
 #include "fan_control.h" // Include the new header
-#include <windows.h>
 #include <iostream> // Keep for potential debug/error output during init/deinit
 #include <vector>
 #include <string>
@@ -11,6 +10,7 @@
 // #include <cstdlib> // No longer needed here (system("cls"))
 // #include <filesystem> // No longer needed here, handled by GUI or main app
 #include <stdexcept> // For throwing errors
+#include <cstring> // For std::memcpy
 
 // #include "json.hpp" // No longer needed here, handled by GUI or main app
 
@@ -87,18 +87,192 @@ namespace { // Use an anonymous namespace for internal linkage
         const uint16_t FAN2_RPM_LSB = 0xC5E2;
         const uint16_t FAN2_RPM_MSB = 0xC5E3;
     }
+
+    // One contiguous EC window fetched in a single sweep, tagged with the field group it feeds.
+    // counter marks multi-byte values the EC updates on its own (consistent reads re-read them).
+    struct EcReadRun {
+        uint16_t addr;
+        uint16_t len;
+        StatusFields group;
+        bool counter = false;
+    };
+
+    // Records an ec_protocol sequence into a port program instead of running it
+    struct PortProgramIo {
+        std::vector<ec_protocol::PortOp>& ops;
+        std::vector<uint8_t*>& reads;
+        void in(uint16_t port, uint8_t* dst) {
+            ops.push_back({ port, 0, 1 });
+            reads.push_back(dst);
+        }
+        void out(uint16_t port, uint8_t value) { ops.push_back({ port, value, 0 }); }
+    };
+
+    // Consistent reads give up on a counter that is still changing after this many re-reads
+    const int COUNTER_STABLE_READS = 4;
+
+    // Every register readStatus samples, grouped into address-sorted contiguous runs so the
+    // high address latch only changes between pages and each run is read back-to-back.
+    // The 6-byte gaps after each 10-byte table are not swept: jumping over them only costs
+    // the low-byte latch write that every byte pays anyway.
+    constexpr EcReadRun STATUS_READ_PLAN[] = {
+        { ITE_REGISTER_MAP::ECHIPID1, 3, STATUS_CHIP_INFO },             // ECHIPID1, ECHIPID2, ECHIPVER
+        { ITE_REGISTER_MAP::FW_VER, 1, STATUS_CHIP_INFO },
+        { ITE_REGISTER_MAP::FAN_CUR_POINT, 1, STATUS_TARGETS },
+        { ITE_REGISTER_MAP::FAN1_BASE, 10, STATUS_CURVES },
+        { ITE_REGISTER_MAP::FAN2_BASE, 10, STATUS_CURVES },
+        { ITE_REGISTER_MAP::FAN_ACC_BASE, 10, STATUS_ACC_DEC },
+        { ITE_REGISTER_MAP::FAN_DEC_BASE, 10, STATUS_ACC_DEC },
+        { ITE_REGISTER_MAP::CPU_TEMP, 10, STATUS_TEMPS },
+        { ITE_REGISTER_MAP::CPU_TEMP_HYST, 10, STATUS_TEMPS },
+        { ITE_REGISTER_MAP::GPU_TEMP, 10, STATUS_TEMPS },
+        { ITE_REGISTER_MAP::GPU_TEMP_HYST, 10, STATUS_TEMPS },
+        { ITE_REGISTER_MAP::VRM_TEMP, 10, STATUS_TEMPS },
+        { ITE_REGISTER_MAP::VRM_TEMP_HYST, 10, STATUS_TEMPS },
+        { ITE_REGISTER_MAP::FAN1_RPM_LSB, 4, STATUS_RPM, true },         // FAN1/FAN2 RPM LSB/MSB
+        { ITE_REGISTER_MAP::FAN1_TARGET_DUTY, 2, STATUS_TARGETS },       // FAN1/FAN2_TARGET_DUTY
+        { ITE_REGISTER_MAP::FAN1_TARGET_CURVE_VAL, 2, STATUS_TARGETS },  // FAN1/FAN2_TARGET_CURVE_VAL
+    };
+
+    constexpr size_t statusPlanBytes() {
+        size_t total = 0;
+        for (const EcReadRun& run : STATUS_READ_PLAN) total += run.len;
+        return total;
+    }
+
+    // Scratch copy of the EC bytes named by STATUS_READ_PLAN, laid out run after run.
+    struct StatusImage {
+        uint8_t bytes[statusPlanBytes()] = {};
+
+        // Pointer to the byte sampled from addr; the address must be covered by the plan.
+        const uint8_t* ptr(uint16_t addr) const {
+            size_t offset = 0;
+            for (const EcReadRun& run : STATUS_READ_PLAN) {
+                if (addr >= run.addr && addr < run.addr + run.len) {
+                    return bytes + offset + (addr - run.addr);
+                }
+                offset += run.len;
+            }
+            throw std::out_of_range("EC address not in status read plan");
+        }
+
+        uint8_t at(uint16_t addr) const { return *ptr(addr); }
+
+        void copyTable(uint16_t addr, EcTable& out) const {
+            std::memcpy(out.data(), ptr(addr), out.size());
+        }
+    };
+
+    // Fills the FanStatusData fields belonging to the requested groups from the image
+    void decodeFields(const StatusImage& image, StatusFields fields, FanStatusData& statusData) {
+        if (fields & STATUS_RPM) {
+            statusData.fan1_speed = (static_cast<uint16_t>(image.at(ITE_REGISTER_MAP::FAN1_RPM_MSB)) << 8) |
+                                    image.at(ITE_REGISTER_MAP::FAN1_RPM_LSB);
+            statusData.fan2_speed = (static_cast<uint16_t>(image.at(ITE_REGISTER_MAP::FAN2_RPM_MSB)) << 8) |
+                                    image.at(ITE_REGISTER_MAP::FAN2_RPM_LSB);
+
+            // Calculate percentages using the class static constants
+            statusData.fan1_percent = (FanController::MAX_FAN1_RPM > 0) ?
+                               static_cast<int>((static_cast<double>(statusData.fan1_speed) / FanController::MAX_FAN1_RPM) * 100.0) :
+                               0;
+            statusData.fan2_percent = (FanController::MAX_FAN2_RPM > 0) ?
+                               static_cast<int>((static_cast<double>(statusData.fan2_speed) / FanController::MAX_FAN2_RPM) * 100.0) :
+                               0;
+        }
+
+        if (fields & STATUS_TARGETS) {
+            statusData.fan1_target_duty = image.at(ITE_REGISTER_MAP::FAN1_TARGET_DUTY);
+            statusData.fan2_target_duty = image.at(ITE_REGISTER_MAP::FAN2_TARGET_DUTY);
+            statusData.fan1_target_curve_val = image.at(ITE_REGISTER_MAP::FAN1_TARGET_CURVE_VAL);
+            statusData.fan2_target_curve_val = image.at(ITE_REGISTER_MAP::FAN2_TARGET_CURVE_VAL);
+            statusData.fan_cur_point = image.at(ITE_REGISTER_MAP::FAN_CUR_POINT);
+        }
+
+        if (fields & STATUS_CURVES) {
+            image.copyTable(ITE_REGISTER_MAP::FAN1_BASE, statusData.fan1_curve);
+            image.copyTable(ITE_REGISTER_MAP::FAN2_BASE, statusData.fan2_curve);
+        }
+
+        if (fields & STATUS_ACC_DEC) {
+            image.copyTable(ITE_REGISTER_MAP::FAN_ACC_BASE, statusData.acc_time);
+            image.copyTable(ITE_REGISTER_MAP::FAN_DEC_BASE, statusData.dec_time);
+        }
+
+        if (fields & STATUS_TEMPS) {
+            image.copyTable(ITE_REGISTER_MAP::CPU_TEMP, statusData.cpu_upper_temp);
+            image.copyTable(ITE_REGISTER_MAP::CPU_TEMP_HYST, statusData.cpu_lower_temp);
+            image.copyTable(ITE_REGISTER_MAP::GPU_TEMP, statusData.gpu_upper_temp);
+            image.copyTable(ITE_REGISTER_MAP::GPU_TEMP_HYST, statusData.gpu_lower_temp);
+            image.copyTable(ITE_REGISTER_MAP::VRM_TEMP, statusData.vrm_upper_temp); // Renamed from IC
+            image.copyTable(ITE_REGISTER_MAP::VRM_TEMP_HYST, statusData.vrm_lower_temp); // Renamed from IC
+        }
+
+        if (fields & STATUS_CHIP_INFO) {
+            statusData.chip_id1 = image.at(ITE_REGISTER_MAP::ECHIPID1);
+            statusData.chip_id2 = image.at(ITE_REGISTER_MAP::ECHIPID2);
+            statusData.chip_ver = image.at(ITE_REGISTER_MAP::ECHIPVER);
+            // Assuming FW_VER is a single byte read based on original code, but declared as uint16_t.
+            // If it's truly 16-bit, it needs two reads. Let's assume single byte for now.
+            // If issues arise, check EC documentation for FW_VER address structure.
+            statusData.fw_ver = image.at(ITE_REGISTER_MAP::FW_VER); // Read as single byte
+        }
+    }
+
+    // One of the ten 10-byte tables writeConfig owns, and where it lives in both structs
+    struct ConfigTable {
+        const char* name;
+        uint16_t addr;
+        StatusFields group;
+        EcTable FanConfigData::*config;
+        EcTable FanStatusData::*status;
+        size_t member; // Table index in ConfigEntryMask (FanConfigData member order)
+    };
+
+    // Config tables in EC address order, so a write sweep never leaves the 0xC5 page
+    const ConfigTable CONFIG_TABLES[] = {
+        { "fan1_curve", ITE_REGISTER_MAP::FAN1_BASE, STATUS_CURVES, &FanConfigData::fan1_curve, &FanStatusData::fan1_curve, 0 },
+        { "fan2_curve", ITE_REGISTER_MAP::FAN2_BASE, STATUS_CURVES, &FanConfigData::fan2_curve, &FanStatusData::fan2_curve, 1 },
+        { "acc_time", ITE_REGISTER_MAP::FAN_ACC_BASE, STATUS_ACC_DEC, &FanConfigData::acc_time, &FanStatusData::acc_time, 2 },
+        { "dec_time", ITE_REGISTER_MAP::FAN_DEC_BASE, STATUS_ACC_DEC, &FanConfigData::dec_time, &FanStatusData::dec_time, 3 },
+        { "cpu_upper_temp", ITE_REGISTER_MAP::CPU_TEMP, STATUS_TEMPS, &FanConfigData::cpu_upper_temp, &FanStatusData::cpu_upper_temp, 5 },
+        { "cpu_lower_temp", ITE_REGISTER_MAP::CPU_TEMP_HYST, STATUS_TEMPS, &FanConfigData::cpu_lower_temp, &FanStatusData::cpu_lower_temp, 4 },
+        { "gpu_upper_temp", ITE_REGISTER_MAP::GPU_TEMP, STATUS_TEMPS, &FanConfigData::gpu_upper_temp, &FanStatusData::gpu_upper_temp, 7 },
+        { "gpu_lower_temp", ITE_REGISTER_MAP::GPU_TEMP_HYST, STATUS_TEMPS, &FanConfigData::gpu_lower_temp, &FanStatusData::gpu_lower_temp, 6 },
+        { "vrm_upper_temp", ITE_REGISTER_MAP::VRM_TEMP, STATUS_TEMPS, &FanConfigData::vrm_upper_temp, &FanStatusData::vrm_upper_temp, 9 }, // Renamed from IC
+        { "vrm_lower_temp", ITE_REGISTER_MAP::VRM_TEMP_HYST, STATUS_TEMPS, &FanConfigData::vrm_lower_temp, &FanStatusData::vrm_lower_temp, 8 }, // Renamed from IC
+    };
 } // end anonymous namespace
 
+void copyConfigEntries(const FanConfigData& from, const ConfigEntryMask& entries, FanConfigData& to) {
+    for (const ConfigTable& table : CONFIG_TABLES) {
+        const uint16_t mask = entries.tables[table.member];
+        for (size_t i = 0; i < (to.*table.config).size(); ++i) {
+            if (mask & (1u << i)) {
+                (to.*table.config)[i] = (from.*table.config)[i];
+            }
+        }
+    }
+}
+
 // --- FanController Implementation ---
 
-FanController::FanController() : hWinRing0Wrapper(nullptr), winring_init_ok(false) {
-    // Constructor: Initialize pointers to null
-    pLoadWinRing0 = nullptr;
-    pInitWinRing0 = nullptr;
-    pReadPort = nullptr;
-    pWritePort = nullptr;
-    pGetStatus = nullptr;
-    pDeinitWinRing0 = nullptr;
+FanController::FanController() : backend(createDefaultPortBackend()), port_init_ok(false) {
+    setup_shadow_regions();
+}
+
+FanController::FanController(std::unique_ptr<PortBackend> portBackend) : backend(std::move(portBackend)), port_init_ok(false) {
+    setup_shadow_regions();
+}
+
+// Puts every static register of the read plan (tables, chip ID, firmware version) into one
+// shadow region aged by config_refresh_interval. Everything else is never served from the shadow.
+void FanController::setup_shadow_regions() {
+    config_region = shadow.addRegion(config_refresh_interval);
+    for (const EcReadRun& run : STATUS_READ_PLAN) {
+        if (run.group & STATUS_CONFIG) {
+            shadow.assignRegion(config_region, run.addr, run.len);
+        }
+    }
 }
 
 FanController::~FanController() {
@@ -113,293 +287,871 @@ void FanController::setError(const std::string& errorMsg) {
 }
 
 bool FanController::initialize() {
-    if (winring_init_ok) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    if (port_init_ok) {
         return true; // Already initialized
     }
     setError(""); // Clear previous errors
 
-    // Use LoadLibraryA for ANSI compatibility if needed, or LoadLibraryW for Unicode
-    hWinRing0Wrapper = LoadLibraryA("winring_wrapper.dll");
-    if (!hWinRing0Wrapper) {
-        DWORD errorCode = GetLastError();
-        setError("Could not load winring_wrapper.dll. Error code: " + std::to_string(errorCode) + ". Ensure DLL and dependencies (WinRing0x64.dll, MinGW runtimes) are present.");
+    if (!backend) {
+        setError("No I/O port backend is available on this platform (or FAN_CONTROL_BACKEND names an unknown one).");
         return false;
     }
 
-    // Get function pointers
-    pLoadWinRing0 = (LoadWinRing0_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "LoadWinRing0");
-    pInitWinRing0 = (InitWinRing0_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "InitWinRing0");
-    pReadPort = (ReadPort_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "ReadPort");
-    pWritePort = (WritePort_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "WritePort");
-    pGetStatus = (GetStatus_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "GetStatus");
-    pDeinitWinRing0 = (DeinitWinRing0_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "DeinitWinRing0");
-
-    if (!pLoadWinRing0 || !pInitWinRing0 || !pReadPort || !pWritePort || !pGetStatus || !pDeinitWinRing0) {
-        setError("Could not get one or more function addresses from wrapper DLL.");
-        FreeLibrary((HMODULE)hWinRing0Wrapper);
-        hWinRing0Wrapper = nullptr;
+    std::string backendError;
+    if (!backend->open(backendError)) {
+        setError(backendError);
         return false;
     }
 
-    if (!pLoadWinRing0()) {
-         setError("LoadWinRing0() via wrapper failed.");
-         FreeLibrary((HMODULE)hWinRing0Wrapper);
-         hWinRing0Wrapper = nullptr;
-         return false;
-    }
-
-    if (!pInitWinRing0()) {
-        uint32_t status = pGetStatus ? pGetStatus() : 0;
-        setError("InitWinRing0() via wrapper failed. Status: " + std::to_string(status));
-        // Don't call deinit here as init failed, just free library
-        FreeLibrary((HMODULE)hWinRing0Wrapper);
-        hWinRing0Wrapper = nullptr;
+    // Stand-in backends (simulator, a file for /dev/port) neither need nor should contend
+    // for the lock real EC tools share
+    std::string lockError;
+    if (backend->needsSystemLock() && !system_lock.open(lockError)) {
+        backend->close();
+        setError(lockError);
         return false;
     }
 
-    winring_init_ok = true;
+    port_init_ok = true;
+    invalidate_ec_latch(); // EC latch contents are unknown until we program them
+    shadow.invalidateAll(); // Nothing is known about EC RAM until it is read
     return true;
 }
 
 void FanController::deinitialize() {
-    if (hWinRing0Wrapper && winring_init_ok && pDeinitWinRing0) {
-        pDeinitWinRing0();
-    }
-
-    if (hWinRing0Wrapper) {
-        FreeLibrary((HMODULE)hWinRing0Wrapper);
-        hWinRing0Wrapper = nullptr;
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    if (backend) {
+        backend->close();
     }
-    winring_init_ok = false;
-    // Reset pointers
-    pLoadWinRing0 = nullptr;
-    pInitWinRing0 = nullptr;
-    pReadPort = nullptr;
-    pWritePort = nullptr;
-    pGetStatus = nullptr;
-    pDeinitWinRing0 = nullptr;
+    system_lock.close();
+    port_init_ok = false;
+    invalidate_ec_latch();
+    shadow.invalidateAll();
 }
 
 bool FanController::isInitialized() const {
-    return winring_init_ok;
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    return port_init_ok;
 }
 
 std::string FanController::getLastError() const {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
     return lastError;
 }
 
+uint64_t FanController::getLockContentions() const {
+    return ec_lock.contentionCount();
+}
+
+EcLockStats FanController::getEcLockStats() const {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    return system_lock.stats();
+}
+
+void FanController::resetEcLockStats() {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    system_lock.resetStats();
+}
+
+bool FanController::getEcWaitHistogram(EcWaitHistogram& out, bool reset) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    return backend && backend->waitHistogram(out, reset);
+}
+
+bool FanController::setEcWaitPolicy(const EcWaitPolicy& policy) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    return backend && backend->setWaitPolicy(policy);
+}
+
+void FanController::setEcLockTimeout(std::chrono::milliseconds timeout) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    system_lock_timeout = timeout;
+}
+
 
 // --- EC Access Functions (Private) ---
+
+// Takes the system-wide EC lock for the outermost transaction. Another process may have
+// reprogrammed the D2EC latch since we last held it, so our latch tracking starts over.
+void FanController::begin_bus_transaction() {
+    if (system_lock_depth++ > 0 || !system_lock.isOpen()) {
+        return;
+    }
+    if (!system_lock.acquire(system_lock_timeout)) {
+        --system_lock_depth;
+        throw std::runtime_error("Timed out waiting for another program to release the EC lock");
+    }
+    invalidate_ec_latch();
+}
+
+void FanController::end_bus_transaction() {
+    if (--system_lock_depth > 0 || !system_lock.isOpen()) {
+        return;
+    }
+    system_lock.release();
+}
 uint8_t FanController::read_io_port_byte(uint16_t port) {
-    if (!winring_init_ok || !pReadPort) {
+    if (!port_init_ok) {
         // setError("Attempted to read IO port while not initialized."); // Avoid flooding errors
+        invalidate_ec_latch();
         return 0;
     }
-    return pReadPort(port);
+    return backend->readPort(port);
 }
 
 void FanController::write_io_port_byte(uint16_t port, uint8_t value) {
-    if (!winring_init_ok || !pWritePort) {
+    if (!port_init_ok) {
         // setError("Attempted to write IO port while not initialized."); // Avoid flooding errors
+        invalidate_ec_latch();
         return;
     }
-    pWritePort(port, value);
+    backend->writePort(port, value);
+}
+
+void FanController::invalidate_ec_latch() {
+    ec_latch_valid = false;
+    ec_data_selected = false;
+}
+
+// Points the D2EC data register at addr. Only the parts of the index sequence that
+// differ from the last access are sent: the high byte (4 ops) when crossing a 256-byte
+// page, the low byte (4 ops) when the address changes, and the 0x12 data select (3 ops)
+// after either. Re-reading the same address costs no index writes at all.
+void FanController::ec_select_address(uint16_t addr) {
+    const uint8_t hi = static_cast<uint8_t>((addr >> 8) & 0xFF);
+    const uint8_t lo = static_cast<uint8_t>(addr & 0xFF);
+
+    if (!ec_latch_valid || ec_latch_hi != hi) {
+        write_io_port_byte(EC_ADDR_PORT, 0x2E);
+        write_io_port_byte(EC_DATA_PORT, 0x11);
+        write_io_port_byte(EC_ADDR_PORT, 0x2F);
+        write_io_port_byte(EC_DATA_PORT, hi);
+        ec_data_selected = false;
+    }
+
+    if (!ec_latch_valid || ec_latch_lo != lo) {
+        write_io_port_byte(EC_ADDR_PORT, 0x2E);
+        write_io_port_byte(EC_DATA_PORT, 0x10);
+        write_io_port_byte(EC_ADDR_PORT, 0x2F);
+        write_io_port_byte(EC_DATA_PORT, lo);
+        ec_data_selected = false;
+    }
+
+    if (!ec_data_selected) {
+        write_io_port_byte(EC_ADDR_PORT, 0x2E);
+        write_io_port_byte(EC_DATA_PORT, 0x12);
+        write_io_port_byte(EC_ADDR_PORT, 0x2F);
+    }
+
+    // A failed port op above clears the latch; only record it if the whole sequence went out.
+    if (port_init_ok) {
+        note_ec_latch(addr);
+    }
 }
 
 uint8_t FanController::direct_ec_read(uint16_t addr) {
-    // Ensure thread safety if called from multiple threads (using a mutex might be needed)
-    // For now, assuming single-threaded access from the GUI event loop.
-    write_io_port_byte(EC_ADDR_PORT, 0x2E);
-    write_io_port_byte(EC_DATA_PORT, 0x11);
-    write_io_port_byte(EC_ADDR_PORT, 0x2F);
-    write_io_port_byte(EC_DATA_PORT, (addr >> 8) & 0xFF);
-
-    write_io_port_byte(EC_ADDR_PORT, 0x2E);
-    write_io_port_byte(EC_DATA_PORT, 0x10);
-    write_io_port_byte(EC_ADDR_PORT, 0x2F);
-    write_io_port_byte(EC_DATA_PORT, addr & 0xFF);
-
-    write_io_port_byte(EC_ADDR_PORT, 0x2E);
-    write_io_port_byte(EC_DATA_PORT, 0x12);
-    write_io_port_byte(EC_ADDR_PORT, 0x2F);
+    // Caller holds ec_lock, so the index/data sequence below cannot interleave with another thread's
+    BusTransaction bus(*this);
+    ec_select_address(addr);
     return read_io_port_byte(EC_DATA_PORT);
 }
 
 void FanController::direct_ec_write(uint16_t addr, uint8_t data) {
-    // Ensure thread safety if called from multiple threads
-    write_io_port_byte(EC_ADDR_PORT, 0x2E);
-    write_io_port_byte(EC_DATA_PORT, 0x11);
-    write_io_port_byte(EC_ADDR_PORT, 0x2F);
-    write_io_port_byte(EC_DATA_PORT, (addr >> 8) & 0xFF);
-
-    write_io_port_byte(EC_ADDR_PORT, 0x2E);
-    write_io_port_byte(EC_DATA_PORT, 0x10);
-    write_io_port_byte(EC_ADDR_PORT, 0x2F);
-    write_io_port_byte(EC_DATA_PORT, addr & 0xFF);
-
-    write_io_port_byte(EC_ADDR_PORT, 0x2E);
-    write_io_port_byte(EC_DATA_PORT, 0x12);
-    write_io_port_byte(EC_ADDR_PORT, 0x2F);
+    // Caller holds ec_lock
+    BusTransaction bus(*this);
+    ec_select_address(addr);
     write_io_port_byte(EC_DATA_PORT, data);
 }
 
-std::vector<uint8_t> FanController::direct_ec_read_array(uint16_t addr_base, size_t size) {
-    std::vector<uint8_t> buffer(size);
+// Records that the hardware latch now points at addr with the data register selected
+void FanController::note_ec_latch(uint16_t addr) {
+    ec_latch_valid = true;
+    ec_latch_hi = static_cast<uint8_t>((addr >> 8) & 0xFF);
+    ec_latch_lo = static_cast<uint8_t>(addr & 0xFF);
+    ec_data_selected = true;
+}
+
+void FanController::direct_ec_read_block(uint16_t addr_base, uint8_t* out, size_t size) {
+    BusTransaction bus(*this);
+    // Let backends with a native range op (inline port I/O, batched submission) run the sweep
+    if (size > 0 && port_init_ok && backend->ecReadRange(addr_base, out, size)) {
+        note_ec_latch(addr_base + static_cast<uint16_t>(size - 1));
+        return;
+    }
     for (size_t i = 0; i < size; ++i) {
         // Add error handling? What if read fails mid-array?
-        buffer[i] = direct_ec_read(addr_base + static_cast<uint16_t>(i));
+        out[i] = direct_ec_read(addr_base + static_cast<uint16_t>(i));
     }
-    return buffer;
 }
 
-void FanController::direct_ec_write_array(uint16_t addr_base, const std::vector<uint8_t>& data) {
-    if (data.empty()) return;
-    for (size_t i = 0; i < data.size(); ++i) {
+void FanController::direct_ec_write_block(uint16_t addr_base, const uint8_t* data, size_t size) {
+    BusTransaction bus(*this);
+    if (size > 0 && port_init_ok && backend->ecWriteRange(addr_base, data, size)) {
+        note_ec_latch(addr_base + static_cast<uint16_t>(size - 1));
+        return;
+    }
+    for (size_t i = 0; i < size; ++i) {
          // Add error handling?
         direct_ec_write(addr_base + static_cast<uint16_t>(i), data[i]);
     }
 }
 
+// Reads count unrelated addresses. Backends with port programs get them as one call.
+void FanController::direct_ec_read_scattered(const uint16_t* addrs, uint8_t* out, size_t count) {
+    BusTransaction bus(*this);
+    if (count > 1) {
+        port_program.clear();
+        program_reads.clear();
+        PortProgramIo io = { port_program, program_reads };
+        for (size_t i = 0; i < count; ++i) {
+            ec_protocol::readRange(io, addrs[i], &out[i], 1);
+        }
+        if (run_port_program(addrs[count - 1])) {
+            return;
+        }
+    }
+    for (size_t i = 0; i < count; ++i) {
+        out[i] = direct_ec_read(addrs[i]);
+    }
+}
+
+// Hands port_program to the backend in one call and scatters the read results. Returns
+// false if the backend has no port programs; nothing has been sent then.
+bool FanController::run_port_program(uint16_t last_addr) {
+    if (!port_init_ok) {
+        return false;
+    }
+    program_results.resize(program_reads.size());
+    if (!backend->executePortProgram(port_program.data(), port_program.size(), program_results.data())) {
+        return false;
+    }
+    for (size_t i = 0; i < program_reads.size(); ++i) {
+        *program_reads[i] = program_results[i];
+    }
+    note_ec_latch(last_addr);
+    return true;
+}
+
+// Sweeps the runs of the read plan belonging to the requested groups into image_bytes
+// (laid out like StatusImage); runs that are skipped keep whatever the caller left there.
+// Stamps statusData with the telemetry sampling time and skew when telemetry was read.
+void FanController::sweep_read_plan(StatusFields fields, uint8_t* image_bytes, FanStatusData& statusData) {
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    SweepTiming timing;
+    if (consistent_reads) {
+        // Volatile registers first and back-to-back, so they describe one instant
+        sweep_runs(fields & STATUS_TELEMETRY, image_bytes, now, timing);
+        sweep_runs(fields & ~static_cast<uint32_t>(STATUS_TELEMETRY), image_bytes, now, timing);
+    } else {
+        sweep_runs(fields, image_bytes, now, timing);
+    }
+    stamp_timing(timing, statusData);
+}
+
+void FanController::sweep_runs(uint32_t groups, uint8_t* image_bytes, std::chrono::steady_clock::time_point now, SweepTiming& timing) {
+    uint8_t* dst = image_bytes;
+    const size_t run_count = sizeof(STATUS_READ_PLAN) / sizeof(STATUS_READ_PLAN[0]);
+    for (size_t r = 0; r < run_count; ++r) {
+        if (groups & STATUS_READ_PLAN[r].group) {
+            sample_run(r, dst, now, timing);
+        }
+        dst += STATUS_READ_PLAN[r].len;
+    }
+}
+
+// Copies the runs of groups the shadow holds (at any age) into image_bytes and returns the
+// groups it could serve completely
+StatusFields FanController::copy_cached_runs(uint32_t groups, uint8_t* image_bytes) const {
+    uint32_t served = groups;
+    uint8_t* dst = image_bytes;
+    for (const EcReadRun& run : STATUS_READ_PLAN) {
+        if (groups & run.group) {
+            if (shadow.isValid(run.addr, run.len)) {
+                shadow.copyOut(run.addr, dst, run.len);
+            } else {
+                served &= ~static_cast<uint32_t>(run.group);
+            }
+        }
+        dst += run.len;
+    }
+    return static_cast<StatusFields>(served);
+}
+
+// Fills one read plan run into dst: copied from the shadow if fresh there, otherwise read
+// from the EC (settled first if it is a counter and consistent reads are on) and recorded in
+// the shadow. Returns true if the EC was accessed.
+bool FanController::sample_run(size_t run_index, uint8_t* dst, std::chrono::steady_clock::time_point now, SweepTiming& timing) {
+    typedef std::chrono::steady_clock Clock;
+    const EcReadRun& run = STATUS_READ_PLAN[run_index];
+    if (shadow.isFresh(run.addr, run.len, now)) {
+        shadow.copyOut(run.addr, dst, run.len);
+        return false;
+    }
+
+    const Clock::time_point before = Clock::now();
+    direct_ec_read_block(run.addr, dst, run.len);
+    if (consistent_reads && run.counter) {
+        timing.stable = read_counter_stable(run.addr, dst, run.len) && timing.stable;
+    }
+    if (run.group & STATUS_TELEMETRY) {
+        if (!timing.sampled) {
+            timing.first_sample = before;
+            timing.sampled = true;
+        }
+        timing.last_sample = Clock::now();
+    }
+    shadow.fill(run.addr, dst, run.len, now);
+    return true;
+}
+
+void FanController::stamp_timing(const SweepTiming& timing, FanStatusData& statusData) {
+    if (!timing.sampled) {
+        return;
+    }
+    const std::chrono::steady_clock::duration skew = timing.last_sample - timing.first_sample;
+    statusData.sample_time_us = std::chrono::duration_cast<std::chrono::microseconds>((timing.first_sample + skew / 2).time_since_epoch()).count();
+    statusData.sample_skew_us = static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(skew).count());
+    statusData.telemetry_stable = timing.stable;
+}
+
+// Re-reads a multi-byte counter until two consecutive reads agree, so an update landing
+// between the LSB and MSB reads cannot produce a torn value. value holds the first read on
+// entry and the settled (or last) read on return. Returns false if it never settled.
+bool FanController::read_counter_stable(uint16_t addr, uint8_t* value, size_t size) {
+    uint8_t again[8];
+    if (size > sizeof(again)) {
+        return false;
+    }
+    for (int attempt = 0; attempt < COUNTER_STABLE_READS; ++attempt) {
+        direct_ec_read_block(addr, again, size);
+        if (std::memcmp(again, value, size) == 0) {
+            return true;
+        }
+        std::memcpy(value, again, size);
+    }
+    return false;
+}
+
+// Sends up to maxBytes staged shadow bytes to the EC. Several runs go out as one port
+// program where the backend has them, otherwise one block write per contiguous run.
+void FanController::flush_shadow(size_t maxBytes) {
+    clear_flush_runs();
+    collect_flush_runs(0, EcShadowRam::SIZE, maxBytes);
+    send_flush_runs();
+}
+
+void FanController::clear_flush_runs() {
+    flush_runs.clear();
+    port_program.clear();
+    program_reads.clear();
+}
+
+// Moves up to maxBytes staged bytes of [addr, addr + len) into flush_runs and the port
+// program. The shadow marks them clean here; send_flush_runs puts them on the bus.
+void FanController::collect_flush_runs(uint16_t addr, size_t len, size_t maxBytes) {
+    PortProgramIo io = { port_program, program_reads };
+    shadow.flushRange([this, &io](uint16_t runAddr, const uint8_t* data, size_t runLen) {
+        flush_runs.push_back({ runAddr, data, runLen });
+        ec_protocol::writeRange(io, runAddr, data, runLen);
+    }, addr, len, std::chrono::steady_clock::now(), maxBytes);
+}
+
+void FanController::send_flush_runs() {
+    BusTransaction bus(*this);
+    if (flush_runs.size() > 1) {
+        const WriteRun& last = flush_runs.back();
+        if (run_port_program(static_cast<uint16_t>(last.addr + last.len - 1))) {
+            return;
+        }
+    }
+    // A throw below leaves the shadow marked clean; callers invalidate it on any error
+    for (const WriteRun& run : flush_runs) {
+        direct_ec_write_block(run.addr, run.data, run.len);
+    }
+}
+
 // --- Status Reading (Public) ---
 bool FanController::readStatus(FanStatusData& statusData) {
-    if (!winring_init_ok) {
-        setError("WinRing0 not initialized, cannot read status.");
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    invalidateConfigCache(); // Explicit reads (reload, initial load) always go to the EC
+    return readStatus(statusData, STATUS_ALL);
+}
+
+bool FanController::readStatus(FanStatusData& statusData, StatusFields fields) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot read status.");
         return false;
     }
     setError(""); // Clear previous errors
 
     try {
-        // Fan Speeds
-        uint8_t fan1_low = direct_ec_read(ITE_REGISTER_MAP::FAN1_RPM_LSB);
-        uint8_t fan1_high = direct_ec_read(ITE_REGISTER_MAP::FAN1_RPM_MSB);
-        statusData.fan1_speed = (static_cast<uint16_t>(fan1_high) << 8) | fan1_low;
-
-        uint8_t fan2_low = direct_ec_read(ITE_REGISTER_MAP::FAN2_RPM_LSB);
-        uint8_t fan2_high = direct_ec_read(ITE_REGISTER_MAP::FAN2_RPM_MSB);
-        statusData.fan2_speed = (static_cast<uint16_t>(fan2_high) << 8) | fan2_low;
-
-        // Calculate percentages using the class static constants
-        statusData.fan1_percent = (FanController::MAX_FAN1_RPM > 0) ?
-                           static_cast<int>((static_cast<double>(statusData.fan1_speed) / FanController::MAX_FAN1_RPM) * 100.0) :
-                           0;
-        statusData.fan2_percent = (FanController::MAX_FAN2_RPM > 0) ?
-                           static_cast<int>((static_cast<double>(statusData.fan2_speed) / FanController::MAX_FAN2_RPM) * 100.0) :
-                           0;
-
-        // Read curves and temps
-        statusData.fan1_curve = direct_ec_read_array(ITE_REGISTER_MAP::FAN1_BASE, 10);
-        statusData.fan2_curve = direct_ec_read_array(ITE_REGISTER_MAP::FAN2_BASE, 10);
-        statusData.acc_time = direct_ec_read_array(ITE_REGISTER_MAP::FAN_ACC_BASE, 10);
-        statusData.dec_time = direct_ec_read_array(ITE_REGISTER_MAP::FAN_DEC_BASE, 10);
-        statusData.cpu_upper_temp = direct_ec_read_array(ITE_REGISTER_MAP::CPU_TEMP, 10);
-        statusData.cpu_lower_temp = direct_ec_read_array(ITE_REGISTER_MAP::CPU_TEMP_HYST, 10);
-        statusData.gpu_upper_temp = direct_ec_read_array(ITE_REGISTER_MAP::GPU_TEMP, 10);
-        statusData.gpu_lower_temp = direct_ec_read_array(ITE_REGISTER_MAP::GPU_TEMP_HYST, 10);
-        statusData.vrm_upper_temp = direct_ec_read_array(ITE_REGISTER_MAP::VRM_TEMP, 10); // Renamed from IC
-        statusData.vrm_lower_temp = direct_ec_read_array(ITE_REGISTER_MAP::VRM_TEMP_HYST, 10); // Renamed from IC
-
-        // EC Info
-        statusData.chip_id1 = direct_ec_read(ITE_REGISTER_MAP::ECHIPID1);
-        statusData.chip_id2 = direct_ec_read(ITE_REGISTER_MAP::ECHIPID2);
-        statusData.chip_ver = direct_ec_read(ITE_REGISTER_MAP::ECHIPVER);
-        // Assuming FW_VER is a single byte read based on original code, but declared as uint16_t.
-        // If it's truly 16-bit, it needs two reads. Let's assume single byte for now.
-        // If issues arise, check EC documentation for FW_VER address structure.
-        statusData.fw_ver = direct_ec_read(ITE_REGISTER_MAP::FW_VER); // Read as single byte
-
-        // Read other relevant single values
-        statusData.fan1_target_duty = direct_ec_read(ITE_REGISTER_MAP::FAN1_TARGET_DUTY);
-        statusData.fan2_target_duty = direct_ec_read(ITE_REGISTER_MAP::FAN2_TARGET_DUTY);
-        statusData.fan1_target_curve_val = direct_ec_read(ITE_REGISTER_MAP::FAN1_TARGET_CURVE_VAL);
-        statusData.fan2_target_curve_val = direct_ec_read(ITE_REGISTER_MAP::FAN2_TARGET_CURVE_VAL);
-        statusData.fan_cur_point = direct_ec_read(ITE_REGISTER_MAP::FAN_CUR_POINT);
+        // Sweep the selected runs of the read plan into the scratch image, lowest address first
+        StatusImage image;
+        sweep_read_plan(fields, image.bytes, statusData);
+        decodeFields(image, fields, statusData);
+        statusData.fresh_fields = fields;
+
+        return true;
+
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        setError(std::string("Error reading EC status: ") + e.what());
+        return false;
+    } catch (...) {
+         invalidate_ec_latch();
+         setError("Unknown error reading EC status.");
+         return false;
+    }
+}
+
+bool FanController::refreshStatusSlice(FanStatusData& statusData, std::chrono::microseconds budget, bool& passComplete,
+                                       StatusFields fields) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    passComplete = false;
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot read status.");
+        return false;
+    }
+    setError("");
+
+    typedef std::chrono::steady_clock Clock;
+    const Clock::time_point start = Clock::now();
+    const size_t run_count = sizeof(STATUS_READ_PLAN) / sizeof(STATUS_READ_PLAN[0]);
+
+    try {
+        const bool new_pass = !slice_active;
+        if (new_pass) {
+            // New pass: all telemetry in one go so it stays time-coherent
+            slice_active = true;
+            slice_cursor = 0;
+            slice_image.assign(sizeof(StatusImage::bytes), 0);
+            slice_fields = fields;
+            slice_timing = SweepTiming();
+            sweep_runs(slice_fields & STATUS_TELEMETRY, slice_image.data(), start, slice_timing);
+        }
 
+        // Byte offset of the cursor run in the image
+        size_t offset = 0;
+        for (size_t r = 0; r < slice_cursor; ++r) {
+            offset += STATUS_READ_PLAN[r].len;
+        }
+
+        bool progressed = new_pass && slice_timing.sampled;
+        while (slice_cursor < run_count) {
+            const EcReadRun& run = STATUS_READ_PLAN[slice_cursor];
+            if ((slice_fields & run.group) && !(run.group & STATUS_TELEMETRY)) {
+                if (progressed && Clock::now() - start >= budget && !shadow.isFresh(run.addr, run.len, start)) {
+                    break; // Out of budget; resume here next call
+                }
+                progressed = sample_run(slice_cursor, &slice_image[offset], start, slice_timing) || progressed;
+            }
+            offset += run.len;
+            ++slice_cursor;
+        }
 
+        if (slice_cursor < run_count) {
+            return true;
+        }
+
+        StatusImage image;
+        std::memcpy(image.bytes, slice_image.data(), sizeof(image.bytes));
+        decodeFields(image, slice_fields, statusData);
+        statusData.fresh_fields = slice_fields;
+        stamp_timing(slice_timing, statusData);
+        slice_active = false;
+        passComplete = true;
         return true;
 
     } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        slice_active = false;
         setError(std::string("Error reading EC status: ") + e.what());
         return false;
     } catch (...) {
+         invalidate_ec_latch();
+         slice_active = false;
          setError("Unknown error reading EC status.");
          return false;
     }
 }
 
+void FanController::restartStatusRefresh() {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    slice_active = false;
+}
+
+bool FanController::pollStatus(FanStatusData& statusData) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot poll status.");
+        return false;
+    }
+
+    setError("");
+
+    try {
+        // Telemetry from the EC; static registers only ever from the shadow (drift re-reads
+        // are scheduled separately so a poll stays small and bounded)
+        StatusImage image;
+        sweep_read_plan(STATUS_TELEMETRY, image.bytes, statusData);
+        const StatusFields cached = copy_cached_runs(STATUS_CONFIG, image.bytes);
+        decodeFields(image, STATUS_TELEMETRY | cached, statusData);
+        statusData.fresh_fields = STATUS_TELEMETRY;
+        return true;
+
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        setError(std::string("Error polling EC status: ") + e.what());
+        return false;
+    } catch (...) {
+         invalidate_ec_latch();
+         setError("Unknown error polling EC status.");
+         return false;
+    }
+}
+
+bool FanController::configRefreshDue() {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    for (const EcReadRun& run : STATUS_READ_PLAN) {
+        if ((run.group & STATUS_CONFIG) && !shadow.isFresh(run.addr, run.len, now)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void FanController::setConsistentReads(bool enabled) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    consistent_reads = enabled;
+}
+
+void FanController::invalidateConfigCache() {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    for (const EcReadRun& run : STATUS_READ_PLAN) {
+        if (run.group & STATUS_CONFIG) {
+            shadow.expire(run.addr, run.len);
+        }
+    }
+}
+
+void FanController::setConfigRefreshInterval(std::chrono::milliseconds interval) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    config_refresh_interval = interval;
+    // 0 disables periodic re-reads
+    shadow.setRegionMaxAge(config_region, interval.count() > 0 ? interval : std::chrono::milliseconds::max());
+}
+
+
+// Stages the config tables in the shadow, which marks only the bytes the EC does not already
+// hold. Tables the shadow no longer holds fresh (config refresh interval) are re-read from the
+// EC before the diff; that is the only bus access here, flush_shadow sends the staged bytes.
+void FanController::stage_config_tables(const FanConfigData& configData) {
+    lastConfigBytesWritten = 0;
+    lastWrittenBytes.clear();
+
+    const bool rewrite_all = config_rewrite_all; // invalidateConfigShadow: no diff this time
+    config_rewrite_all = false;
+
+    const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+    const size_t table_count = sizeof(CONFIG_TABLES) / sizeof(CONFIG_TABLES[0]);
+    for (size_t t = 0; t < table_count; ++t) {
+        const ConfigTable& table = CONFIG_TABLES[t];
+        const EcTable& wanted = configData.*table.config;
+        if (!rewrite_all && !shadow.isFresh(table.addr, wanted.size(), now)) {
+            EcTable current;
+            direct_ec_read_block(table.addr, current.data(), current.size());
+            shadow.fill(table.addr, current.data(), current.size(), now);
+        }
+        for (size_t i = 0; i < wanted.size(); ++i) {
+            if (shadow.stage(table.addr + static_cast<uint16_t>(i), wanted[i], rewrite_all)) {
+                ++lastConfigBytesWritten;
+                lastWrittenBytes.push_back({ static_cast<uint8_t>(t), static_cast<uint8_t>(i) });
+            }
+        }
+    }
+}
+
+// Updates the duty targets and the current ACC/DEC registers after the tables are written
+void FanController::write_config_targets(const FanConfigData& configData) {
+    // Write target values (replicating original logic - this might need adjustment based on how the EC uses these)
+    // It might be better to let the EC handle these based on the curves written,
+    // but we replicate the original script's behavior for now.
+    // These registers are staged with force (the EC changes them itself) and flushed together
+    // below, so the duty pair and the four ACC/DEC registers each go out as one run.
+    // The three registers this depends on, read in one go (one call with port programs)
+    const uint16_t target_addrs[] = {
+        ITE_REGISTER_MAP::FAN1_TARGET_CURVE_VAL, ITE_REGISTER_MAP::FAN2_TARGET_CURVE_VAL, ITE_REGISTER_MAP::FAN_CUR_POINT
+    };
+    uint8_t targets[3];
+    direct_ec_read_scattered(target_addrs, targets, 3);
+
+    uint8_t fan1_curve_target = targets[0]; // Current target
+    shadow.stage(ITE_REGISTER_MAP::FAN1_TARGET_DUTY, fan1_curve_target, true);
+    // The DCR calculation seems specific and might be EC internal logic. Replicating it might be correct or might interfere.
+    // uint8_t fan1_dcr_val = (fan1_curve_target <= 45) ? static_cast<uint8_t>(fan1_curve_target * 255 / 45) : 255;
+    // direct_ec_write(ITE_REGISTER_MAP::DCR5, fan1_dcr_val); // Commenting out DCR write unless confirmed necessary
+
+    uint8_t fan2_curve_target = targets[1]; // Current target
+    shadow.stage(ITE_REGISTER_MAP::FAN2_TARGET_DUTY, fan2_curve_target, true);
+    // uint8_t fan2_dcr_val = (fan2_curve_target <= 45) ? static_cast<uint8_t>(fan2_curve_target * 255 / 45) : 255;
+    // direct_ec_write(ITE_REGISTER_MAP::DCR4, fan2_dcr_val); // Commenting out DCR write unless confirmed necessary
+
+    // Update current ACC/DEC based on the *current* curve point index read from EC
+    uint8_t acc_dec_time_target_idx = targets[2];
+    if (acc_dec_time_target_idx < configData.acc_time.size()) {
+         shadow.stage(ITE_REGISTER_MAP::FAN1_CUR_ACC, configData.acc_time[acc_dec_time_target_idx], true);
+         shadow.stage(ITE_REGISTER_MAP::FAN2_CUR_ACC, configData.acc_time[acc_dec_time_target_idx], true);
+    } else {
+         // Log warning?
+         setError("Warning: Invalid ACC_time target index read from EC: " + std::to_string(static_cast<int>(acc_dec_time_target_idx)));
+    }
+
+    if (acc_dec_time_target_idx < configData.dec_time.size()) {
+        shadow.stage(ITE_REGISTER_MAP::FAN1_CUR_DEC, configData.dec_time[acc_dec_time_target_idx], true);
+        shadow.stage(ITE_REGISTER_MAP::FAN2_CUR_DEC, configData.dec_time[acc_dec_time_target_idx], true);
+    } else {
+         // Log warning?
+         setError("Warning: Invalid DEC_time target index read from EC: " + std::to_string(static_cast<int>(acc_dec_time_target_idx)));
+    }
+
+    flush_shadow();
+}
+
+// Reads one table byte back from the EC (never the shadow) and records a mismatch. The
+// shadow takes the value actually read so the next writeConfig retries the byte.
+bool FanController::verify_table_byte(const FanConfigData& configData, size_t table, size_t index, ConfigVerifyResult& result) {
+    const ConfigTable& entry = CONFIG_TABLES[table];
+    const uint16_t addr = entry.addr + static_cast<uint16_t>(index);
+    const uint8_t expected = (configData.*entry.config)[index];
+    const uint8_t actual = direct_ec_read(addr);
+    shadow.fill(addr, &actual, 1, std::chrono::steady_clock::now());
+    ++result.bytes_checked;
+    if (actual == expected) {
+        return true;
+    }
+    result.mismatches.push_back({ entry.name, index, addr, expected, actual });
+    return false;
+}
+
+void FanController::invalidateConfigShadow() {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    for (const ConfigTable& table : CONFIG_TABLES) {
+        shadow.invalidate(table.addr, EcTable().size());
+    }
+    config_rewrite_all = true;
+}
+
+size_t FanController::getLastConfigBytesWritten() const {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    return lastConfigBytesWritten;
+}
 
 // --- Write Configuration (Public) ---
 bool FanController::writeConfig(const FanConfigData& configData) {
-    if (!winring_init_ok) {
-        setError("WinRing0 not initialized, cannot write config.");
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot write config.");
         return false;
     }
      setError(""); // Clear previous errors
 
-    // Basic validation (ensure vectors have correct size)
-    if (configData.fan1_curve.size() != 10 || configData.fan2_curve.size() != 10 ||
-        configData.acc_time.size() != 10 || configData.dec_time.size() != 10 ||
-        configData.cpu_lower_temp.size() != 10 || configData.cpu_upper_temp.size() != 10 ||
-        configData.gpu_lower_temp.size() != 10 || configData.gpu_upper_temp.size() != 10 ||
-        configData.vrm_lower_temp.size() != 10 || configData.vrm_upper_temp.size() != 10)
-    {
-        setError("Invalid configuration data: All arrays must have size 10.");
+    // Table sizes are fixed by EcTable, so there is nothing to validate here
+
+    try {
+        // Write only the table bytes that differ from the last known EC image. Runs are
+        // cleared from the dirty set as they go out, so a throw leaves only unsent bytes dirty.
+        stage_config_tables(configData);
+        flush_shadow();
+        write_config_targets(configData);
+        return true;
+
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        shadow.invalidateAll(); // Unknown how far the write got; drop staged bytes too
+        setError(std::string("An error occurred during writeConfig: ") + e.what());
         return false;
+    } catch (...) {
+         invalidate_ec_latch();
+         shadow.invalidateAll();
+         setError("An unknown error occurred during writeConfig.");
+         return false;
     }
+}
+
 
 
+bool FanController::writeConfig(const FanConfigData& configData, VerifyMode mode, ConfigVerifyResult& result) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    result = ConfigVerifyResult();
+    if (!writeConfig(configData)) {
+        return false;
+    }
+    return verify_config(configData, mode, result);
+}
+
+// Chunked writeConfig: stage everything up front, send it a slice at a time, then finish
+bool FanController::beginConfigWrite(const FanConfigData& configData) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot write config.");
+        return false;
+    }
+    setError("");
     try {
-        // Write arrays to EC
-        direct_ec_write_array(ITE_REGISTER_MAP::FAN1_BASE, configData.fan1_curve);
-        direct_ec_write_array(ITE_REGISTER_MAP::FAN2_BASE, configData.fan2_curve);
-        direct_ec_write_array(ITE_REGISTER_MAP::CPU_TEMP, configData.cpu_upper_temp);
-        direct_ec_write_array(ITE_REGISTER_MAP::GPU_TEMP, configData.gpu_upper_temp);
-        direct_ec_write_array(ITE_REGISTER_MAP::VRM_TEMP, configData.vrm_upper_temp); // Renamed from IC
-        direct_ec_write_array(ITE_REGISTER_MAP::CPU_TEMP_HYST, configData.cpu_lower_temp);
-        direct_ec_write_array(ITE_REGISTER_MAP::GPU_TEMP_HYST, configData.gpu_lower_temp);
-        direct_ec_write_array(ITE_REGISTER_MAP::VRM_TEMP_HYST, configData.vrm_lower_temp); // Renamed from IC
-        direct_ec_write_array(ITE_REGISTER_MAP::FAN_ACC_BASE, configData.acc_time);
-        direct_ec_write_array(ITE_REGISTER_MAP::FAN_DEC_BASE, configData.dec_time);
-
-        // Write target values (replicating original logic - this might need adjustment based on how the EC uses these)
-        // It might be better to let the EC handle these based on the curves written,
-        // but we replicate the original script's behavior for now.
-        uint8_t fan1_curve_target = direct_ec_read(ITE_REGISTER_MAP::FAN1_TARGET_CURVE_VAL); // Read current target
-        direct_ec_write(ITE_REGISTER_MAP::FAN1_TARGET_DUTY, fan1_curve_target);
-        // The DCR calculation seems specific and might be EC internal logic. Replicating it might be correct or might interfere.
-        // uint8_t fan1_dcr_val = (fan1_curve_target <= 45) ? static_cast<uint8_t>(fan1_curve_target * 255 / 45) : 255;
-        // direct_ec_write(ITE_REGISTER_MAP::DCR5, fan1_dcr_val); // Commenting out DCR write unless confirmed necessary
-
-        uint8_t fan2_curve_target = direct_ec_read(ITE_REGISTER_MAP::FAN2_TARGET_CURVE_VAL); // Read current target
-        direct_ec_write(ITE_REGISTER_MAP::FAN2_TARGET_DUTY, fan2_curve_target);
-        // uint8_t fan2_dcr_val = (fan2_curve_target <= 45) ? static_cast<uint8_t>(fan2_curve_target * 255 / 45) : 255;
-        // direct_ec_write(ITE_REGISTER_MAP::DCR4, fan2_dcr_val); // Commenting out DCR write unless confirmed necessary
-
-        // Update current ACC/DEC based on the *current* curve point index read from EC
-        uint8_t acc_dec_time_target_idx = direct_ec_read(ITE_REGISTER_MAP::FAN_CUR_POINT);
-        if (acc_dec_time_target_idx < configData.acc_time.size()) {
-             direct_ec_write(ITE_REGISTER_MAP::FAN1_CUR_ACC, configData.acc_time[acc_dec_time_target_idx]);
-             direct_ec_write(ITE_REGISTER_MAP::FAN2_CUR_ACC, configData.acc_time[acc_dec_time_target_idx]);
-        } else {
-             // Log warning?
-             setError("Warning: Invalid ACC_time target index read from EC: " + std::to_string(static_cast<int>(acc_dec_time_target_idx)));
-        }
+        stage_config_tables(configData);
+        return true;
 
-        if (acc_dec_time_target_idx < configData.dec_time.size()) {
-            direct_ec_write(ITE_REGISTER_MAP::FAN1_CUR_DEC, configData.dec_time[acc_dec_time_target_idx]);
-            direct_ec_write(ITE_REGISTER_MAP::FAN2_CUR_DEC, configData.dec_time[acc_dec_time_target_idx]);
-        } else {
-             // Log warning?
-             setError("Warning: Invalid DEC_time target index read from EC: " + std::to_string(static_cast<int>(acc_dec_time_target_idx)));
-        }
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        shadow.invalidateAll();
+        setError(std::string("An error occurred during writeConfig: ") + e.what());
+        return false;
+    } catch (...) {
+         invalidate_ec_latch();
+         shadow.invalidateAll();
+         setError("An unknown error occurred during writeConfig.");
+         return false;
+    }
+}
 
+bool FanController::continueConfigWrite(size_t maxBytes, bool& done) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    done = false;
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot write config.");
+        return false;
+    }
+    try {
+        flush_shadow(maxBytes);
+        done = shadow.dirtyCount() == 0;
         return true;
 
     } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        shadow.invalidateAll();
+        setError(std::string("An error occurred during writeConfig: ") + e.what());
+        return false;
+    } catch (...) {
+         invalidate_ec_latch();
+         shadow.invalidateAll();
+         setError("An unknown error occurred during writeConfig.");
+         return false;
+    }
+}
+
+bool FanController::finishConfigWrite(const FanConfigData& configData, VerifyMode mode, ConfigVerifyResult& result) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    result = ConfigVerifyResult();
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot write config.");
+        return false;
+    }
+    try {
+        flush_shadow(); // Whatever continueConfigWrite has not sent yet
+        write_config_targets(configData);
+
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        shadow.invalidateAll();
         setError(std::string("An error occurred during writeConfig: ") + e.what());
         return false;
     } catch (...) {
+         invalidate_ec_latch();
+         shadow.invalidateAll();
          setError("An unknown error occurred during writeConfig.");
          return false;
     }
+    return verify_config(configData, mode, result);
+}
+
+bool FanController::writeConfigEntries(const FanConfigData& configData, const ConfigEntryMask& entries, size_t& bytesWritten) {
+    std::lock_guard<EcTransactionLock> lock(ec_lock);
+    bytesWritten = 0;
+    if (!port_init_ok) {
+        setError("Port backend not initialized, cannot write config.");
+        return false;
+    }
+    setError("");
+    try {
+        // Leaves lastWrittenBytes alone: a chunked apply in progress still verifies its own bytes.
+        // Every selected entry is sent even if the shadow already holds its value: the shadow
+        // may be stale, and an edit back to a cached value must still reach the EC. Only these
+        // entries go out; bytes a chunked apply staged wait for its own slices.
+        clear_flush_runs();
+        for (const ConfigTable& table : CONFIG_TABLES) {
+            const EcTable& wanted = configData.*table.config;
+            const uint16_t mask = entries.tables[table.member];
+            size_t i = 0;
+            while (i < wanted.size()) {
+                if (!(mask & (1u << i))) {
+                    ++i;
+                    continue;
+                }
+                const size_t first = i; // One run per block of adjacent selected entries
+                for (; i < wanted.size() && (mask & (1u << i)); ++i) {
+                    shadow.stage(table.addr + static_cast<uint16_t>(i), wanted[i], true);
+                }
+                collect_flush_runs(table.addr + static_cast<uint16_t>(first), i - first, EcShadowRam::SIZE);
+                bytesWritten += i - first;
+            }
+        }
+        send_flush_runs();
+        return true;
+
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        shadow.invalidateAll();
+        setError(std::string("An error occurred during writeConfigEntries: ") + e.what());
+        return false;
+    } catch (...) {
+         invalidate_ec_latch();
+         shadow.invalidateAll();
+         setError("An unknown error occurred during writeConfigEntries.");
+         return false;
+    }
 }
 
+// Reads back the bytes selected by mode after a write. Always returns true: a failed
+// read-back is reported through lastError, not as a failed write.
+bool FanController::verify_config(const FanConfigData& configData, VerifyMode mode, ConfigVerifyResult& result) {
+    if (mode == VerifyMode::None) {
+        result.verified = true;
+        return true;
+    }
+
+    // No settle delay: the tables live in EC RAM, so a read-back reflects the write immediately
+    try {
+        bool ok = true;
+        if (mode == VerifyMode::WrittenBytes) {
+            for (const WrittenByte& written : lastWrittenBytes) {
+                ok = verify_table_byte(configData, written.table, written.index, result) && ok;
+            }
+        } else {
+            const size_t table_count = sizeof(CONFIG_TABLES) / sizeof(CONFIG_TABLES[0]);
+            for (size_t t = 0; t < table_count; ++t) {
+                for (size_t i = 0; i < (configData.*CONFIG_TABLES[t].config).size(); ++i) {
+                    ok = verify_table_byte(configData, t, i, result) && ok;
+                }
+            }
+        }
+        result.verified = ok;
+        if (!ok) {
+            setError("Config verification failed: " + std::to_string(result.mismatches.size()) + " byte(s) differ.");
+        }
+        return true;
+
+    } catch (const std::exception& e) {
+        invalidate_ec_latch();
+        invalidateConfigShadow();
+        setError(std::string("An error occurred during config verification: ") + e.what());
+        return true;
+    } catch (...) {
+         invalidate_ec_latch();
+         invalidateConfigShadow();
+         setError("An unknown error occurred during config verification.");
+         return true;
+    }
+}
\ No newline at end of file
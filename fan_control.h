@@ -2,25 +2,55 @@
 #define FAN_CONTROL_H
 
 #include <vector>
+#include <array>
 #include <cstdint>
+#include <type_traits>
+#include <memory>
+#include "port_backend.h"
+#include "ec_shadow.h"
+#include "ec_lock.h"
 #include <string>
+#include <chrono>
 
-// Structure to hold the status data read from the EC
+// Field groups for selective status reads. Combine with | and pass to readStatus.
+enum StatusFields : uint32_t {
+    STATUS_NONE      = 0,
+    STATUS_RPM       = 1u << 0, // fan1/fan2_speed, fan1/fan2_percent
+    STATUS_TARGETS   = 1u << 1, // fan1/fan2_target_duty, fan1/fan2_target_curve_val, fan_cur_point
+    STATUS_CURVES    = 1u << 2, // fan1_curve, fan2_curve
+    STATUS_TEMPS     = 1u << 3, // cpu/gpu/vrm lower and upper temp tables
+    STATUS_ACC_DEC   = 1u << 4, // acc_time, dec_time
+    STATUS_CHIP_INFO = 1u << 5, // chip_id1, chip_id2, chip_ver, fw_ver
+
+    STATUS_TELEMETRY = STATUS_RPM | STATUS_TARGETS,
+    STATUS_CONFIG    = STATUS_CURVES | STATUS_TEMPS | STATUS_ACC_DEC | STATUS_CHIP_INFO,
+    STATUS_ALL       = STATUS_TELEMETRY | STATUS_CONFIG,
+};
+
+inline StatusFields operator|(StatusFields a, StatusFields b) {
+    return static_cast<StatusFields>(static_cast<uint32_t>(a) | static_cast<uint32_t>(b));
+}
+
+// One 10-entry EC table (curve points, temperature thresholds, acc/dec times)
+typedef std::array<uint8_t, 10> EcTable;
+
+// Structure to hold the status data read from the EC.
+// Fixed-size and trivially copyable: a snapshot is a plain memcpy with no heap traffic.
 struct FanStatusData {
     uint16_t fan1_speed = 0;
     uint16_t fan2_speed = 0;
     int fan1_percent = 0;
     int fan2_percent = 0;
-    std::vector<uint8_t> fan1_curve;
-    std::vector<uint8_t> fan2_curve;
-    std::vector<uint8_t> acc_time;
-    std::vector<uint8_t> dec_time;
-    std::vector<uint8_t> cpu_lower_temp;
-    std::vector<uint8_t> cpu_upper_temp;
-    std::vector<uint8_t> gpu_lower_temp;
-    std::vector<uint8_t> gpu_upper_temp;
-    std::vector<uint8_t> vrm_lower_temp; // Renamed from IC
-    std::vector<uint8_t> vrm_upper_temp; // Renamed from IC
+    EcTable fan1_curve = {};
+    EcTable fan2_curve = {};
+    EcTable acc_time = {};
+    EcTable dec_time = {};
+    EcTable cpu_lower_temp = {};
+    EcTable cpu_upper_temp = {};
+    EcTable gpu_lower_temp = {};
+    EcTable gpu_upper_temp = {};
+    EcTable vrm_lower_temp = {}; // Renamed from IC
+    EcTable vrm_upper_temp = {}; // Renamed from IC
     uint8_t chip_id1 = 0;
     uint8_t chip_id2 = 0;
     uint8_t chip_ver = 0;
@@ -30,34 +60,65 @@ struct FanStatusData {
     uint8_t fan1_target_curve_val = 0;
     uint8_t fan2_target_curve_val = 0;
     uint8_t fan_cur_point = 0;
+    StatusFields fresh_fields = STATUS_NONE; // Groups sampled from the EC by the last read
 
-    // Add default sizes for vectors to avoid issues if read fails partially
-    FanStatusData() :
-        fan1_curve(10, 0), fan2_curve(10, 0), acc_time(10, 0), dec_time(10, 0),
-        cpu_lower_temp(10, 0), cpu_upper_temp(10, 0), gpu_lower_temp(10, 0), gpu_upper_temp(10, 0),
-        vrm_lower_temp(10, 0), vrm_upper_temp(10, 0) {}
+    // When the telemetry registers (RPM, targets, curve point) were sampled: steady_clock time
+    // halfway through their reads, in microseconds, and the time from first to last byte.
+    int64_t sample_time_us = 0;
+    uint32_t sample_skew_us = 0;
+    bool telemetry_stable = true; // Consistent reads: every multi-byte counter settled
 };
 
-// Structure to hold the configuration data to write to the EC
+// Structure to hold the configuration data to write to the EC (trivially copyable, like FanStatusData)
 struct FanConfigData {
-    std::vector<uint8_t> fan1_curve;
-    std::vector<uint8_t> fan2_curve;
-    std::vector<uint8_t> acc_time;
-    std::vector<uint8_t> dec_time;
-    std::vector<uint8_t> cpu_lower_temp;
-    std::vector<uint8_t> cpu_upper_temp;
-    std::vector<uint8_t> gpu_lower_temp;
-    std::vector<uint8_t> gpu_upper_temp;
-    std::vector<uint8_t> vrm_lower_temp; // Renamed from IC
-    std::vector<uint8_t> vrm_upper_temp; // Renamed from IC
-
-     // Constructor to ensure vectors have the correct size
-    FanConfigData() :
-        fan1_curve(10, 0), fan2_curve(10, 0), acc_time(10, 0), dec_time(10, 0),
-        cpu_lower_temp(10, 0), cpu_upper_temp(10, 0), gpu_lower_temp(10, 0), gpu_upper_temp(10, 0),
-        vrm_lower_temp(10, 0), vrm_upper_temp(10, 0) {}
+    EcTable fan1_curve = {};
+    EcTable fan2_curve = {};
+    EcTable acc_time = {};
+    EcTable dec_time = {};
+    EcTable cpu_lower_temp = {};
+    EcTable cpu_upper_temp = {};
+    EcTable gpu_lower_temp = {};
+    EcTable gpu_upper_temp = {};
+    EcTable vrm_lower_temp = {}; // Renamed from IC
+    EcTable vrm_upper_temp = {}; // Renamed from IC
+};
+
+static_assert(std::is_trivially_copyable<FanStatusData>::value, "FanStatusData must stay memcpy-able");
+static_assert(std::is_trivially_copyable<FanConfigData>::value, "FanConfigData must stay memcpy-able");
+
+// How writeConfig checks its work after writing
+enum class VerifyMode {
+    None,         // No read-back
+    WrittenBytes, // Read back only the bytes this write actually sent
+    AllTables,    // Read back all 100 table bytes
+};
+
+// One table byte whose read-back value differs from what was written
+struct ConfigMismatch {
+    const char* field;  // FanConfigData member name, e.g. "fan1_curve"
+    size_t index;       // Index within that table
+    uint16_t addr;      // EC address
+    uint8_t expected;
+    uint8_t actual;
+};
+
+// Outcome of a verified writeConfig
+struct ConfigVerifyResult {
+    bool verified = false;
+    size_t bytes_checked = 0;
+    std::vector<ConfigMismatch> mismatches;
 };
 
+// Selects individual table entries of a FanConfigData: one bit per entry, tables in
+// FanConfigData member order (fan1_curve, fan2_curve, acc_time, dec_time, cpu_lower_temp, ...)
+struct ConfigEntryMask {
+    static const size_t TABLES = 10;
+    uint16_t tables[TABLES] = {};
+};
+
+// Copies the entries of from selected by entries into to
+void copyConfigEntries(const FanConfigData& from, const ConfigEntryMask& entries, FanConfigData& to);
+
 
 class FanController {
 public:
@@ -65,54 +126,251 @@ public:
     static const uint16_t MAX_FAN1_RPM = 5200;
     static const uint16_t MAX_FAN2_RPM = 5000;
 
+    // Holds the controller's EC transaction lock for its lifetime, so a caller can make several
+    // calls (e.g. readStatus then writeConfig, or writeConfig then getLastError) without another
+    // thread's EC access in between. Every public method also locks on its own, so this is only
+    // needed to group calls.
+    class Transaction {
+    public:
+        explicit Transaction(FanController& controller) : owner(controller) { owner.ec_lock.lock(); }
+        ~Transaction() { owner.ec_lock.unlock(); }
+        Transaction(const Transaction&) = delete;
+        Transaction& operator=(const Transaction&) = delete;
+
+    private:
+        FanController& owner;
+    };
+
+    // Uses the platform's default port backend (WinRing0 on Windows), or the one named by
+    // FAN_CONTROL_BACKEND
     FanController();
+    // Uses the given port backend, e.g. SimulatedEcPortBackend for off-target runs
+    explicit FanController(std::unique_ptr<PortBackend> portBackend);
     ~FanController();
 
-    // Initializes the WinRing0 library
+    // Opens the port backend
     bool initialize();
 
-    // Deinitializes the WinRing0 library
+    // Closes the port backend
     void deinitialize();
 
-    // Reads the current status from the EC
+    // Reads the current status from the EC, static configuration registers included: an
+    // explicit full read never serves them from the shadow (see invalidateConfigCache)
     bool readStatus(FanStatusData& statusData);
 
-    // Writes the given configuration to the EC
+    // Reads only the registers for the requested field groups. Other fields are left
+    // untouched; statusData.fresh_fields reports which groups were refreshed. Static
+    // registers are served from the EC shadow while younger than the config refresh
+    // interval; telemetry registers always go to the EC.
+    bool readStatus(FanStatusData& statusData, StatusFields fields);
+
+    // Tiered poll: samples only the fast-changing telemetry registers (RPM, target duty/curve
+    // values, current curve point) and takes the static config/identity fields from the EC
+    // shadow whatever their age, so its cost never includes a config sweep. Groups the shadow
+    // does not hold at all are left untouched. Keeping them current is the caller's job: see
+    // configRefreshDue.
+    bool pollStatus(FanStatusData& statusData);
+
+    // True once the static registers pollStatus serves from the shadow are older than the
+    // config refresh interval, were expired (invalidateConfigCache) or were never read.
+    // Re-read them with refreshStatusSlice(..., STATUS_CONFIG) or readStatus.
+    bool configRefreshDue();
+
+    // Time-sliced status refresh for callers that cannot afford a full sweep in one call.
+    // Each call continues the current pass over the read plan and reads from the EC only
+    // while budget lasts (at least one step per call, so a pass always advances). The
+    // telemetry registers are read together in the first step of a pass. statusData is only
+    // written when a pass completes, which sets passComplete; it then holds one decoded
+    // snapshot of fields, like readStatus. Runs the shadow holds fresh cost no budget.
+    bool refreshStatusSlice(FanStatusData& statusData, std::chrono::microseconds budget, bool& passComplete,
+                            StatusFields fields = STATUS_ALL);
+
+    // Drops a partly done refreshStatusSlice pass; the next call starts a new one
+    void restartStatusRefresh();
+
+    // Consistent-read mode: telemetry registers are sampled back-to-back ahead of everything
+    // else, and multi-byte counters (fan RPM) are re-read until two reads agree so an update
+    // between the LSB and MSB reads cannot tear the value. Off by default.
+    void setConsistentReads(bool enabled);
+
+    // Forces the next readStatus or refreshStatusSlice to re-read the static configuration registers
+    void invalidateConfigCache();
+
+    // Drift-check interval for the cached static registers (default 5 s; 0 disables periodic
+    // re-reads). Past it, readStatus re-reads them and configRefreshDue reports true.
+    void setConfigRefreshInterval(std::chrono::milliseconds interval);
+
+    // Writes the given configuration to the EC. Only table bytes that differ from the EC
+    // shadow are sent, as coalesced runs. Tables older than the config refresh interval are
+    // re-read first; changes other programs make in between are left to the drift re-read
+    // and to VerifyMode::AllTables.
     bool writeConfig(const FanConfigData& configData);
 
-    // Returns true if WinRing0 was initialized successfully
+    // Writes the configuration, then reads back the bytes selected by mode and reports any
+    // per-byte mismatches in result. Returns false only if the write itself failed.
+    bool writeConfig(const FanConfigData& configData, VerifyMode mode, ConfigVerifyResult& result);
+
+    // writeConfig in slices, for schedulers that need to run other EC work in between (see
+    // EcWorker). beginConfigWrite stages the changed table bytes (re-reading stale tables);
+    // each continueConfigWrite sends up to maxBytes of them and sets done once none are left;
+    // finishConfigWrite sends any rest, updates the duty and ACC/DEC registers and verifies
+    // like writeConfig(config, mode, result). A writeConfig or another beginConfigWrite in
+    // between simply takes over the bytes still pending.
+    bool beginConfigWrite(const FanConfigData& configData);
+    bool continueConfigWrite(size_t maxBytes, bool& done);
+    bool finishConfigWrite(const FanConfigData& configData, VerifyMode mode, ConfigVerifyResult& result);
+
+    // Live-edit write: sends only the entries of configData selected by entries (e.g. one curve
+    // point's value, its upper temp and the next point's lower temp), each one even if the
+    // shadow shows the EC already holds it. Bytes a chunked apply staged are left for its own
+    // slices. No duty/ACC-DEC update and no read-back. Sets bytesWritten.
+    bool writeConfigEntries(const FanConfigData& configData, const ConfigEntryMask& entries, size_t& bytesWritten);
+
+    // Forces the next writeConfig to rewrite every table byte
+    void invalidateConfigShadow();
+
+    // Number of table bytes the last writeConfig actually sent to the EC
+    size_t getLastConfigBytesWritten() const;
+
+    // Returns true if the port backend was opened successfully
     bool isInitialized() const;
 
-    // Gets the last error message
+    // Gets the last error message. Shared by all threads; read it inside the same
+    // Transaction as the failing call to be sure it is that call's error.
     std::string getLastError() const;
 
+    // Starts a Transaction on this controller
+    Transaction transaction() { return Transaction(*this); }
+
+    // Number of EC transactions that had to wait for another thread
+    uint64_t getLockContentions() const;
+
+    // Wait/hold statistics of the system-wide EC lock shared with other processes
+    EcLockStats getEcLockStats() const;
+    void resetEcLockStats();
+
+    // Ready-wait statistics of the port backend (WinRing0: EC input buffer polls before each
+    // port op, once enabled through setEcWaitPolicy), optionally resetting them. Returns false
+    // if the backend cannot wait.
+    bool getEcWaitHistogram(EcWaitHistogram& out, bool reset = false);
+
+    // Tunes the backend's ready-wait phases; the wait itself stays off unless
+    // policy.ready_check is set. Returns false if the backend cannot wait.
+    bool setEcWaitPolicy(const EcWaitPolicy& policy);
+
+    // How long one EC transaction waits for another process before failing (default 100 ms)
+    void setEcLockTimeout(std::chrono::milliseconds timeout);
+
 private:
-    // WinRing0 function pointers and handle
-    void* hWinRing0Wrapper = nullptr; // Use void* for HMODULE
-    typedef bool (*LoadWinRing0_t)();
-    typedef bool (*InitWinRing0_t)();
-    typedef uint8_t (*ReadPort_t)(uint16_t port);
-    typedef void (*WritePort_t)(uint16_t port, uint8_t value);
-    typedef uint32_t (*GetStatus_t)();
-    typedef void (*DeinitWinRing0_t)();
-
-    LoadWinRing0_t pLoadWinRing0 = nullptr;
-    InitWinRing0_t pInitWinRing0 = nullptr;
-    ReadPort_t pReadPort = nullptr;
-    WritePort_t pWritePort = nullptr;
-    GetStatus_t pGetStatus = nullptr;
-    DeinitWinRing0_t pDeinitWinRing0 = nullptr;
-
-    bool winring_init_ok = false;
+    // Serializes every public call. Private helpers assume it is held.
+    mutable EcTransactionLock ec_lock;
+
+    // Port I/O backend (WinRing0, simulator, ...)
+    std::unique_ptr<PortBackend> backend;
+
+    bool port_init_ok = false;
     std::string lastError;
 
+    // Taken around each EC transaction (one byte, one block, one write run) so other programs
+    // using the SuperIO ports can only cut in between transactions. Holds stay short: the
+    // longest is a single 10-byte table.
+    EcSystemLock system_lock;
+    unsigned system_lock_depth = 0;
+    std::chrono::milliseconds system_lock_timeout{100};
+
+    // Holds system_lock for one EC transaction; nests so block ops can use the byte helpers
+    class BusTransaction {
+    public:
+        explicit BusTransaction(FanController& controller) : owner(controller) { owner.begin_bus_transaction(); }
+        ~BusTransaction() { owner.end_bus_transaction(); }
+        BusTransaction(const BusTransaction&) = delete;
+        BusTransaction& operator=(const BusTransaction&) = delete;
+
+    private:
+        FanController& owner;
+    };
+
+    // Last values programmed into the D2EC address latch (SuperIO regs 0x11/0x10).
+    // Lets consecutive EC accesses skip redundant index writes.
+    bool ec_latch_valid = false;
+    uint8_t ec_latch_hi = 0;
+    uint8_t ec_latch_lo = 0;
+    bool ec_data_selected = false; // 0x2E holds 0x12 and the index port is parked on 0x2F
+
+    // Shadow of the EC address space. Serves the static registers (config tables, chip ID,
+    // firmware version) while they are younger than config_refresh_interval, gives
+    // writeConfig the last known table bytes so it only sends changes, and coalesces
+    // staged writes into runs.
+    EcShadowRam shadow;
+    int config_region = 0; // Shadow staleness region of the static registers
+    std::chrono::milliseconds config_refresh_interval{5000};
+    size_t lastConfigBytesWritten = 0;
+    bool config_rewrite_all = false; // Next stage_config_tables sends every byte (invalidateConfigShadow)
+    bool consistent_reads = false;
+
+    // Scratch for port programs (run_port_program): the ops, where each read's result goes,
+    // and the write runs of a flush in case the backend declines the program
+    struct WriteRun {
+        uint16_t addr;
+        const uint8_t* data;
+        size_t len;
+    };
+    std::vector<ec_protocol::PortOp> port_program;
+    std::vector<uint8_t*> program_reads;
+    std::vector<uint8_t> program_results;
+    std::vector<WriteRun> flush_runs;
+
+    // Telemetry sampling window of a sweep, stamped into FanStatusData afterwards
+    struct SweepTiming {
+        std::chrono::steady_clock::time_point first_sample;
+        std::chrono::steady_clock::time_point last_sample;
+        bool sampled = false;
+        bool stable = true;
+    };
+
+    // refreshStatusSlice pass state
+    std::vector<uint8_t> slice_image; // Laid out like the readStatus scratch image
+    bool slice_active = false;        // A pass is in progress
+    size_t slice_cursor = 0;          // Next read plan run of the pass
+    StatusFields slice_fields = STATUS_NONE;
+    SweepTiming slice_timing;
+
+    // Table bytes sent by the last stage_config_tables, as (CONFIG_TABLES index, byte index)
+    struct WrittenByte {
+        uint8_t table;
+        uint8_t index;
+    };
+    std::vector<WrittenByte> lastWrittenBytes;
+
     // Low-level EC access functions
+    void begin_bus_transaction();
+    void end_bus_transaction();
     uint8_t read_io_port_byte(uint16_t port);
     void write_io_port_byte(uint16_t port, uint8_t value);
+    void ec_select_address(uint16_t addr);
+    void invalidate_ec_latch();
+    void note_ec_latch(uint16_t addr);
     uint8_t direct_ec_read(uint16_t addr);
     void direct_ec_write(uint16_t addr, uint8_t data);
-    std::vector<uint8_t> direct_ec_read_array(uint16_t addr_base, size_t size);
-    void direct_ec_write_array(uint16_t addr_base, const std::vector<uint8_t>& data);
+    void direct_ec_read_block(uint16_t addr_base, uint8_t* out, size_t size);
+    void direct_ec_write_block(uint16_t addr_base, const uint8_t* data, size_t size);
+    void direct_ec_read_scattered(const uint16_t* addrs, uint8_t* out, size_t count);
+    bool run_port_program(uint16_t last_addr);
+    void sweep_read_plan(StatusFields fields, uint8_t* image_bytes, FanStatusData& statusData);
+    void sweep_runs(uint32_t groups, uint8_t* image_bytes, std::chrono::steady_clock::time_point now, SweepTiming& timing);
+    StatusFields copy_cached_runs(uint32_t groups, uint8_t* image_bytes) const;
+    bool sample_run(size_t run, uint8_t* dst, std::chrono::steady_clock::time_point now, SweepTiming& timing);
+    static void stamp_timing(const SweepTiming& timing, FanStatusData& statusData);
+    bool read_counter_stable(uint16_t addr, uint8_t* value, size_t size);
+    void setup_shadow_regions();
+    void flush_shadow(size_t maxBytes = EcShadowRam::SIZE);
+    void clear_flush_runs();
+    void collect_flush_runs(uint16_t addr, size_t len, size_t maxBytes);
+    void send_flush_runs();
+    void stage_config_tables(const FanConfigData& configData);
+    void write_config_targets(const FanConfigData& configData);
+    bool verify_config(const FanConfigData& configData, VerifyMode mode, ConfigVerifyResult& result);
+    bool verify_table_byte(const FanConfigData& configData, size_t table, size_t index, ConfigVerifyResult& result);
 
     // Helper to set last error
     void setError(const std::string& errorMsg);
@@ -8,74 +8,57 @@
 #include <string>
 #include <chrono>
 #include <numeric> // For std::iota
-#include <algorithm> // For std::sort
+#include <algorithm> // For std::min/std::max
+#include <atomic>
 #include <json.hpp> // Assuming json.hpp is from nlohmann
 #include "fan_control.h"
-
-// Helper function to convert vector<uint8_t> to vector<int> for ImGui sliders
-std::vector<int> convertVecU8ToVecInt(const std::vector<uint8_t>& vec_u8) {
-    std::vector<int> vec_int;
-    vec_int.reserve(vec_u8.size());
-    for (uint8_t val : vec_u8) {
-        vec_int.push_back(static_cast<int>(val));
-    }
-    return vec_int;
-}
-
-// Helper function to convert vector<int> back to vector<uint8_t> 
-std::vector<uint8_t> convertVecIntToVecU8(const std::vector<int>& vec_int) {
-    std::vector<uint8_t> vec_u8;
-    vec_u8.reserve(vec_int.size());
-    for (int val : vec_int) {
-        // Clamp values to the valid uint8_t range
-        if (val < 0) val = 0;
-        if (val > 255) val = 255;
-        vec_u8.push_back(static_cast<uint8_t>(val));
-    }
-    return vec_u8;
-}
-
-struct PlotPoint {
-    int temp;
-    int rpm;
-    size_t original_index; // Keep track of original index if needed for other arrays
-
-    // Sort by temperature
-    bool operator<(const PlotPoint& other) const {
-        return temp < other.temp;
+#include "ec_worker.h"
+#include "telemetry_history.h"
+#include "editable_config.h"
+
+// Set from SDL tray menu callbacks, handled by the main loop
+struct TrayRequests {
+    bool show = false;
+    bool quit = false;
+    Uint32 wakeEvent = 0; // ecEventType; pushed so a loop blocked in SDL_WaitEventTimeout sees the request
+
+    void wake() const {
+        if (wakeEvent != 0) {
+            SDL_Event event;
+            SDL_zero(event);
+            event.type = wakeEvent;
+            SDL_PushEvent(&event);
+        }
     }
 };
 
-// Helper to create sorted PlotPoint vectors for plotting/editing
-std::vector<PlotPoint> createPlotPoints(const std::vector<int>& temps, const std::vector<int>& curve_points_scaled) {
-    std::vector<PlotPoint> points;
-    size_t n = std::min(temps.size(), curve_points_scaled.size());
-    points.reserve(n);
-    for (size_t i = 0; i < n; ++i) {
-        // Assuming curve_points_scaled is 0-100, convert to RPM for plot
-        points.push_back({temps[i], curve_points_scaled[i] * 100, i});
+// Vertex arrays for one curve plot. Kept across frames and refreshed only when the curve's
+// points change (drag or reload), so drawing the plot does no conversion or allocation.
+struct CurvePlotBuffer {
+    std::vector<double> temps;
+    std::vector<double> rpms;
+    bool dirty = true;
+
+    void update(const CurvePoints& curve) {
+        temps.resize(curve.size()); // Same size every time after the first call: no reallocation
+        rpms.resize(curve.size());
+        if (curve.size() > 0) {
+            updateRange(curve, 0, curve.size() - 1);
+        }
+        dirty = false;
     }
-    std::sort(points.begin(), points.end()); // Sort by temperature for plotting
-    return points;
-}
-
-// Helper to extract data back from PlotPoints
-void extractDataFromPlotPoints(const std::vector<PlotPoint>& points, std::vector<int>& temps, std::vector<int>& curve_points_scaled) {
-    // Create temporary vectors to hold the potentially reordered data
-    std::vector<int> temp_temps(temps.size());
-    std::vector<int> temp_curve_points(curve_points_scaled.size());
-
-    for (const auto& p : points) {
-        if (p.original_index < temp_temps.size()) {
-            temp_temps[p.original_index] = p.temp;
-            // Convert RPM back to 0-100 scale for storage
-            temp_curve_points[p.original_index] = p.rpm / 100;
+
+    // Refreshes sorted positions [first, last] only, e.g. after CurvePoints::move
+    void updateRange(const CurvePoints& curve, size_t first, size_t last) {
+        for (size_t r = first; r <= last && r < curve.size(); ++r) {
+            const PlotPoint& p = curve.point(curve.idAt(r));
+            temps[r] = static_cast<double>(p.temp);
+            rpms[r] = static_cast<double>(p.rpm);
         }
     }
-    // Assign back to original vectors
-    temps = temp_temps;
-    curve_points_scaled = temp_curve_points;
-}
+
+    int size() const { return static_cast<int>(temps.size()); }
+};
 
 int main(int argc, char* argv[]) {
     
@@ -127,94 +110,299 @@ int main(int argc, char* argv[]) {
     // Main loop
     bool done = false;
 
+    // --- Rendering Mode ---
+    // On-demand: the loop sleeps in SDL_WaitEventTimeout until input, a worker snapshot/result
+    // or the text cursor blink, then renders a few frames. Hidden (minimized or in the tray):
+    // nothing is rendered and the worker polls at trayPollIntervalMs.
+    const int FRAMES_AFTER_INPUT = 3;       // ImGui needs a couple of frames to settle hover/layout
+    const Sint32 TEXT_INPUT_WAKE_MS = 500;  // Cursor blink while a text field is active
+    const int ACTIVE_POLL_INTERVAL_MS = 100;
+    bool onDemandRendering = true;
+    int trayPollIntervalMs = 1000;
+    int framesToRender = FRAMES_AFTER_INPUT;
+    bool wasHidden = false;
+    SDL_Tray* tray = nullptr;
+    TrayRequests trayRequests;
+    char trayTooltip[96];
+
+    // Worker notifications arrive as one SDL user event at a time (coalesced by wakePending)
+    std::atomic<bool> wakePending{false};
+    const Uint32 ecEventType = SDL_RegisterEvents(1);
+    trayRequests.wakeEvent = ecEventType;
+
     // --- Fan Control Logic Initialization ---
-    FanController fanController;
-    FanConfigData currentConfig; // Holds the currently applied config
+    // --backend=<name> picks the port backend (winring0, ioperm, dev-port, simulator); without
+    // it the FAN_CONTROL_BACKEND environment variable or the platform default is used
+    std::string backendName;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg.compare(0, 10, "--backend=") == 0) {
+            backendName = arg.substr(10);
+        }
+    }
+    std::unique_ptr<PortBackend> portBackend = backendName.empty() ? createDefaultPortBackend() : createPortBackend(backendName);
+    if (!portBackend) {
+        printf("No port backend available%s%s.\n", backendName.empty() ? "" : " named ", backendName.c_str());
+    }
+
+    // All EC I/O runs on the worker thread; the render loop only consumes snapshots and results
+    EcWorker ecWorker(std::move(portBackend));
+    if (ecEventType != 0) {
+        ecWorker.setNotifier([&wakePending, ecEventType]() {
+            if (!wakePending.exchange(true)) {
+                SDL_Event wake;
+                SDL_zero(wake);
+                wake.type = ecEventType;
+                if (!SDL_PushEvent(&wake)) { // Thread-safe
+                    wakePending.store(false); // Full queue or filtered: let the next notification retry
+                }
+            }
+        });
+    }
     FanStatusData currentStatus; // Holds the latest status read
+    EcStatusSnapshot latestSnapshot;
+    EcCommandResult commandResult;
+    TelemetryHistory telemetryHistory; // Preallocated; feeds the live chart
+    int historyWindowSeconds = 300;    // Visible span of the live chart
     std::string statusMessage = "Initializing...";
     bool controllerInitialized = false;
 
-    if (fanController.initialize()) {
-        controllerInitialized = true;
-        // Read initial status, which includes current config settings
-        if (fanController.readStatus(currentStatus)) {
-            statusMessage = "Controller Initialized. Status/Config loaded.";
-            // Copy config parts from status to currentConfig
-            currentConfig.fan1_curve = currentStatus.fan1_curve;
-            currentConfig.fan2_curve = currentStatus.fan2_curve;
-            currentConfig.acc_time = currentStatus.acc_time;
-            currentConfig.dec_time = currentStatus.dec_time;
-            currentConfig.cpu_lower_temp = currentStatus.cpu_lower_temp;
-            currentConfig.cpu_upper_temp = currentStatus.cpu_upper_temp;
-            currentConfig.gpu_lower_temp = currentStatus.gpu_lower_temp;
-            currentConfig.gpu_upper_temp = currentStatus.gpu_upper_temp;
-            currentConfig.vrm_lower_temp = currentStatus.vrm_lower_temp;
-            currentConfig.vrm_upper_temp = currentStatus.vrm_upper_temp;
-        } else {
-            statusMessage = "Controller Initialized, but failed to read initial status/config: " + fanController.getLastError();
-            // Use default config (from FanConfigData constructor) if read fails
-            currentConfig = FanConfigData();
+    // Initializes the controller and reads the initial status/config in the background.
+    // Until that result arrives the editor shows the default config (from the FanConfigData constructor).
+    ecWorker.start();
+
+    // Single editable config: widgets and plots edit it in place and it tracks what changed
+    EditableConfig editableConfig;
+    ConfigEntryMask pendingApplyDirty; // Changes handed to applies not yet verified
+    CurvePlotBuffer fan1_plot_buffer;
+    CurvePlotBuffer fan2_plot_buffer;
+
+    // --- Live Apply ---
+    // While a curve point is dragged, only its bytes are streamed to the EC: at most one write
+    // in flight and at most one per liveApplyIntervalMs. Positions in between are dropped;
+    // the newest one goes out when the slot opens.
+    bool liveApply = false;
+    int liveApplyIntervalMs = 50;
+    bool liveInFlight = false;
+    bool livePendingAny = false;
+    ConfigEntryMask livePending; // Entries dragged since the last live write was sent
+    std::chrono::steady_clock::time_point liveLastSend;
+    bool liveSentSinceApply = false; // The next Apply skips those bytes, so it reads back all tables
+
+    // Copies the config parts of a full status read into the editable config and refreshes the plots
+    auto loadEditableFromStatus = [&](const FanStatusData& status) {
+        editableConfig.loadFromStatus(status);
+        fan1_plot_buffer.dirty = true;
+        fan2_plot_buffer.dirty = true;
+    };
+
+    // Byte-table entry as an ImGui slider; edits go straight into the model
+    auto sliderByte = [&](const char* label, EditableConfig::Field field, size_t index) {
+        int value = editableConfig.get(field, index);
+        if (ImGui::SliderInt(label, &value, 0, 255)) {
+            editableConfig.set(field, index, value);
         }
-    } else {
-        statusMessage = "Failed to initialize Fan Controller: " + fanController.getLastError();
-        // Use default config if controller init fails
-        currentConfig = FanConfigData();
-    }
-
-    // Create editable copy and int versions for ImGui
-    FanConfigData editableConfig = currentConfig;
-    std::vector<int> fan1_curve_int = convertVecU8ToVecInt(editableConfig.fan1_curve);
-    std::vector<int> fan2_curve_int = convertVecU8ToVecInt(editableConfig.fan2_curve);
-    std::vector<int> cpu_upper_temp_int = convertVecU8ToVecInt(editableConfig.cpu_upper_temp);
-    std::vector<int> gpu_upper_temp_int = convertVecU8ToVecInt(editableConfig.gpu_upper_temp);
-    // Assuming acc_time/dec_time vectors have at least 2 elements (for fan1, fan2)
-    int fan1_acc_time_int = (editableConfig.acc_time.size() > 0) ? editableConfig.acc_time[0] : 0;
-    int fan1_dec_time_int = (editableConfig.dec_time.size() > 0) ? editableConfig.dec_time[0] : 0;
-    int fan2_acc_time_int = (editableConfig.acc_time.size() > 1) ? editableConfig.acc_time[1] : 0;
-    int fan2_dec_time_int = (editableConfig.dec_time.size() > 1) ? editableConfig.dec_time[1] : 0;
-    // Correct initialization for lower temp int vectors
-    std::vector<int> cpu_lower_temp_int = convertVecU8ToVecInt(editableConfig.cpu_lower_temp);
-    std::vector<int> gpu_lower_temp_int = convertVecU8ToVecInt(editableConfig.gpu_lower_temp);
-    // Data For Plots
-    std::vector<PlotPoint> fan1_plot_points = createPlotPoints(cpu_upper_temp_int, fan1_curve_int);
-    std::vector<PlotPoint> fan2_plot_points = createPlotPoints(gpu_upper_temp_int, fan2_curve_int);
+    };
 
     // Main loop state
     // bool done = false;
-    auto lastUpdateTime = std::chrono::steady_clock::now();
     ImVec4 clear_color = ImVec4(0.1f, 0.1f, 0.1f, 1.00f); // Adjusted clear color
 
     while (!done)
 
     {
+        const bool hidden = tray != nullptr || (SDL_GetWindowFlags(window) & (SDL_WINDOW_MINIMIZED | SDL_WINDOW_HIDDEN)) != 0;
+        if (hidden != wasHidden) {
+            ecWorker.setPollInterval(std::chrono::milliseconds(hidden ? trayPollIntervalMs : ACTIVE_POLL_INTERVAL_MS));
+            framesToRender = FRAMES_AFTER_INPUT;
+            wasHidden = hidden;
+        }
+
+        // How long to sleep: not at all while visible frames are owed (or in continuous mode);
+        // otherwise until the next event. Without the worker event, fall back to the poll interval.
+        Sint32 timeout;
+        if (!hidden && (framesToRender > 0 || !onDemandRendering)) {
+            timeout = 0;
+        } else if (ecEventType == 0) {
+            timeout = hidden ? trayPollIntervalMs : ACTIVE_POLL_INTERVAL_MS;
+        } else if (!hidden && io.WantTextInput) {
+            timeout = TEXT_INPUT_WAKE_MS;
+        } else {
+            timeout = -1;
+        }
+        if (livePendingAny && !liveInFlight && timeout != 0) {
+            // Wake up when the rate limit lets the held-back live write go
+            const auto sinceSend = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - liveLastSend);
+            const Sint32 untilSlot = static_cast<Sint32>(std::max<int64_t>(0, liveApplyIntervalMs - sinceSend.count()));
+            timeout = (timeout < 0) ? untilSlot : std::min(timeout, untilSlot);
+        }
+
         SDL_Event event;
-        while (SDL_PollEvent(&event)) {
-            ImGui_ImplSDL3_ProcessEvent(&event);
-            if (event.type == SDL_EVENT_QUIT)
-                done = true;
-            if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && event.window.windowID == SDL_GetWindowID(window))
-                done = true;
+        bool gotEvent = SDL_WaitEventTimeout(&event, timeout);
+        if (!gotEvent && timeout > 0 && !hidden) {
+            framesToRender = 1; // Cursor blink or fallback poll
+        }
+        while (gotEvent) {
+            if (ecEventType != 0 && event.type == ecEventType) {
+                wakePending.store(false);
+                framesToRender = std::max(framesToRender, 1); // New data only needs one frame
+            } else {
+                ImGui_ImplSDL3_ProcessEvent(&event);
+                if (event.type == SDL_EVENT_QUIT)
+                    done = true;
+                if (event.type == SDL_EVENT_WINDOW_CLOSE_REQUESTED && event.window.windowID == SDL_GetWindowID(window))
+                    done = true;
+                framesToRender = FRAMES_AFTER_INPUT;
+            }
+            gotEvent = SDL_PollEvent(&event);
+        }
+
+        // Tray menu callbacks run while SDL pumps events above
+        if (trayRequests.quit) {
+            done = true;
+        }
+        if (trayRequests.show) {
+            trayRequests.show = false;
+            SDL_DestroyTray(tray);
+            tray = nullptr;
+            SDL_ShowWindow(window);
+            SDL_RaiseWindow(window);
+        }
+
+        // --- Worker Updates (never blocks on EC I/O) ---
+        // The worker polls telemetry at ~10 Hz; static config comes from the controller's cache
+        if (ecWorker.latestSnapshot(latestSnapshot)) {
+            if (latestSnapshot.ok) {
+                currentStatus = latestSnapshot.status;
+                telemetryHistory.push(currentStatus);
+                if (tray != nullptr) {
+                    snprintf(trayTooltip, sizeof(trayTooltip), "Fan Control - Fan 1: %d RPM, Fan 2: %d RPM",
+                             currentStatus.fan1_speed, currentStatus.fan2_speed);
+                    SDL_SetTrayTooltip(tray, trayTooltip);
+                }
+            } else {
+                statusMessage = "Error reading status: " + latestSnapshot.error;
+            }
+        }
+
+        while (ecWorker.pollResult(commandResult)) {
+            switch (commandResult.type) {
+            case EcCommandType::Initialize:
+                controllerInitialized = ecWorker.isInitialized();
+                if (commandResult.ok) {
+                    statusMessage = "Controller Initialized. Status/Config loaded.";
+                    currentStatus = commandResult.status;
+                    loadEditableFromStatus(currentStatus);
+                } else if (controllerInitialized) {
+                    statusMessage = "Controller Initialized, but failed to read initial status/config: " + commandResult.error;
+                } else {
+                    statusMessage = commandResult.error;
+                }
+                break;
+
+            case EcCommandType::ApplyConfig:
+                if (commandResult.ok) {
+                    printf("fanController.writeConfig returned TRUE (%zu table bytes written).\n", commandResult.bytes_written); // Log success
+
+                   // --- Verification Result (read back of the written bytes only) ---
+                   const ConfigVerifyResult& verifyResult = commandResult.verify;
+                   if (verifyResult.verified) {
+                       statusMessage = "Config written and verified successfully (" + std::to_string(verifyResult.bytes_checked) + " bytes checked).";
+                       pendingApplyDirty = ConfigEntryMask();
+                       printf("Verified %zu byte(s).\n", verifyResult.bytes_checked);
+                   } else {
+                       std::string verificationError = "";
+                       for (const ConfigMismatch& m : verifyResult.mismatches) {
+                           verificationError += " " + std::string(m.field) + "[" + std::to_string(m.index) + "] mismatch.";
+                       }
+                       statusMessage = "Config written, but VERIFICATION FAILED:" + verificationError;
+                       editableConfig.markDirty(pendingApplyDirty);
+                       pendingApplyDirty = ConfigEntryMask();
+                       printf("--- VERIFICATION FAILED ---\n");
+                       printf("Verification Error Details: %s\n", commandResult.error.c_str());
+                       for (const ConfigMismatch& m : verifyResult.mismatches) {
+                           printf("  %s[%zu] @ 0x%04X: expected %d, actual %d\n", m.field, m.index, m.addr, m.expected, m.actual);
+                       }
+                   }
+                   printf("---------------------------\n"); // Log end of verification
+                } else {
+                    // Log failure and the error message
+                    printf("fanController.writeConfig returned FALSE.\n");
+                    editableConfig.markDirty(pendingApplyDirty);
+                    pendingApplyDirty = ConfigEntryMask();
+                    statusMessage = "Error writing config: " + commandResult.error;
+                    printf("Error details: %s\n", commandResult.error.c_str());
+                }
+                printf("--- Apply Config Action Finished ---\n"); // Log end of action
+                break;
+
+            case EcCommandType::ReloadConfig:
+                if (commandResult.ok) {
+                    statusMessage = "Config reloaded from EC.";
+                    currentStatus = commandResult.status;
+
+                    // --- DEBUG: Print raw data from readStatus ---
+                    printf("--- Reloading ---\n");
+                    printf("Raw Fan 1 Curve (readStatus): ");
+                    for(uint8_t val : currentStatus.fan1_curve) { printf("%d ", val); } printf("\n");
+                    printf("Raw CPU Upper Temp (readStatus): ");
+                    for(uint8_t val : currentStatus.cpu_upper_temp) { printf("%d ", val); } printf("\n");
+                    printf("Raw Fan 2 Curve (readStatus): ");
+                    for(uint8_t val : currentStatus.fan2_curve) { printf("%d ", val); } printf("\n");
+                    printf("Raw GPU Upper Temp (readStatus): ");
+                    for(uint8_t val : currentStatus.gpu_upper_temp) { printf("%d ", val); } printf("\n");
+                    // --- END DEBUG ---
+
+                    loadEditableFromStatus(currentStatus);
+                    livePending = ConfigEntryMask(); // The EC's values win over undelivered drags
+                    livePendingAny = false;
+                    liveSentSinceApply = false;
+
+                    // --- DEBUG: Print generated plot points ---
+                    printf("Generated Fan 1 Plot Points (Temp, RPM): ");
+                    for(size_t r = 0; r < editableConfig.curve(0).size(); ++r) { const PlotPoint& p = editableConfig.curve(0).point(editableConfig.curve(0).idAt(r)); printf("(%d, %d) ", p.temp, p.rpm); } printf("\n");
+                    printf("Generated Fan 2 Plot Points (Temp, RPM): ");
+                    for(size_t r = 0; r < editableConfig.curve(1).size(); ++r) { const PlotPoint& p = editableConfig.curve(1).point(editableConfig.curve(1).idAt(r)); printf("(%d, %d) ", p.temp, p.rpm); } printf("\n");
+                    printf("-----------------\n");
+                    // --- END DEBUG ---
+                } else {
+                    statusMessage = "Error reloading config from EC: " + commandResult.error;
+                }
+                break;
+
+            case EcCommandType::LiveEdit:
+                liveInFlight = false; // Next dragged position may go
+                if (!commandResult.ok) {
+                    statusMessage = "Live apply failed: " + commandResult.error;
+                }
+                break;
+
+            case EcCommandType::Poll:
+            case EcCommandType::ConfigRefresh:
+                break; // Worker-internal; polls are published through snapshots, never as results
+            }
         }
 
-        if (SDL_GetWindowFlags(window) & SDL_WINDOW_MINIMIZED)
+        // --- Live Apply: send the newest dragged position once the slot and rate limit allow ---
+        if (livePendingAny && !liveInFlight) {
+            const std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+            if (now - liveLastSend >= std::chrono::milliseconds(liveApplyIntervalMs)) {
+                liveLastSend = now; // Also paces retries while the worker queue is full
+                if (ecWorker.submitLiveEdit(editableConfig.data(), livePending)) {
+                    liveInFlight = true;
+                    liveSentSinceApply = true;
+                    livePending = ConfigEntryMask();
+                    livePendingAny = false;
+                }
+            }
+        }
+
+        // Snapshots and results above are still consumed while hidden; only drawing stops
+        if (hidden || done || (onDemandRendering && framesToRender == 0))
         {
-            SDL_Delay(10);
             continue;
         }
 
-         // --- Periodic Update ---\n       
-        auto now = std::chrono::steady_clock::now();
-         auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(now - lastUpdateTime).count();
-         if (controllerInitialized && elapsed > 1000) { // Update status every second
-             lastUpdateTime = now;
-             if (!fanController.readStatus(currentStatus)) {
-                  statusMessage = "Error reading status: " + fanController.getLastError();
-             } else {
-                 // Optionally clear status message on successful read
-                 // statusMessage = "Status updated.";
-             }
-         }
-
         // Start the Dear ImGui frame
         ImGui_ImplSDLRenderer3_NewFrame();
         ImGui_ImplSDL3_NewFrame();
@@ -231,6 +419,34 @@ int main(int argc, char* argv[]) {
             ImGui::Text("  Fan 1 Speed: %d RPM (%d%%)", currentStatus.fan1_speed, currentStatus.fan1_percent);
             ImGui::Text("  Fan 2 Speed: %d RPM (%d%%)", currentStatus.fan2_speed, currentStatus.fan2_percent);
             ImGui::Text("  FW Ver: %d, Chip: %02X%02X, Ver: %02X", currentStatus.fw_ver, currentStatus.chip_id1, currentStatus.chip_id2, currentStatus.chip_ver);
+
+            // --- Live Telemetry Chart ---
+            // Plots straight out of the history ring (offset = oldest sample), no per-frame copies
+            ImGui::SliderInt("History (s)", &historyWindowSeconds, 10, 600);
+            if (ImPlot::BeginPlot("Telemetry", ImVec2(-1, 250), ImPlotFlags_NoTitle)) {
+                const double latest = telemetryHistory.latestTime();
+                ImPlot::SetupAxes("Time (s)", "RPM", ImPlotAxisFlags_None, ImPlotAxisFlags_None);
+                ImPlot::SetupAxis(ImAxis_Y2, "Duty / Percent", ImPlotAxisFlags_AuxDefault);
+                ImPlot::SetupAxis(ImAxis_Y3, "Curve Point", ImPlotAxisFlags_AuxDefault);
+                ImPlot::SetupAxisLimits(ImAxis_X1, latest - historyWindowSeconds, latest, ImPlotCond_Always);
+                ImPlot::SetupAxisLimits(ImAxis_Y1, 0, 5300, ImPlotCond_Once);
+                ImPlot::SetupAxisLimits(ImAxis_Y2, 0, 255, ImPlotCond_Once); // Target duty is a raw byte
+                ImPlot::SetupAxisLimits(ImAxis_Y3, 0, 10, ImPlotCond_Once);
+
+                const int count = static_cast<int>(telemetryHistory.size());
+                const int offset = telemetryHistory.offset();
+                const double* t = telemetryHistory.times();
+                ImPlot::PlotLine("Fan 1 RPM", t, telemetryHistory.fan1Rpm(), count, 0, offset);
+                ImPlot::PlotLine("Fan 2 RPM", t, telemetryHistory.fan2Rpm(), count, 0, offset);
+                ImPlot::SetAxes(ImAxis_X1, ImAxis_Y2);
+                ImPlot::PlotLine("Fan 1 %", t, telemetryHistory.fan1Percent(), count, 0, offset);
+                ImPlot::PlotLine("Fan 2 %", t, telemetryHistory.fan2Percent(), count, 0, offset);
+                ImPlot::PlotLine("Fan 1 Target Duty", t, telemetryHistory.fan1TargetDuty(), count, 0, offset);
+                ImPlot::PlotLine("Fan 2 Target Duty", t, telemetryHistory.fan2TargetDuty(), count, 0, offset);
+                ImPlot::SetAxes(ImAxis_X1, ImAxis_Y3);
+                ImPlot::PlotStairs("Curve Point", t, telemetryHistory.curvePoint(), count, 0, offset);
+                ImPlot::EndPlot();
+            }
             ImGui::Separator();
 
             ImGui::Text("Configuration:");
@@ -248,42 +464,36 @@ int main(int argc, char* argv[]) {
                 ImPlot::SetupAxisLimits(ImAxis_X1, 0 - tempPadding, 127 + tempPadding); // Temp with padding
                 ImPlot::SetupAxisLimits(ImAxis_Y1, 0 - rpmPadding1, 5200 + rpmPadding1); // RPM with padding
 
-                // Prepare data for plotting (needs arrays of doubles or floats)
-                std::vector<double> temps_d(fan1_plot_points.size());
-                std::vector<double> rpms_d(fan1_plot_points.size());
-                for(size_t i = 0; i < fan1_plot_points.size(); ++i) {
-                    temps_d[i] = static_cast<double>(fan1_plot_points[i].temp);
-                    rpms_d[i] = static_cast<double>(fan1_plot_points[i].rpm);
+                // Plot the line connecting the points (vertex arrays only change after a drag/reload)
+                if (fan1_plot_buffer.dirty) {
+                    fan1_plot_buffer.update(editableConfig.curve(0));
                 }
-
-                // Plot the line connecting the points
-                ImPlot::PlotLine("Curve", temps_d.data(), rpms_d.data(), fan1_plot_points.size());
+                ImPlot::PlotLine("Curve", fan1_plot_buffer.temps.data(), fan1_plot_buffer.rpms.data(), fan1_plot_buffer.size());
 
                 // Add draggable points
                 ImPlot::SetNextMarkerStyle(ImPlotMarker_Circle);
-                for (size_t i = 0; i < fan1_plot_points.size(); ++i) {
+                // Points are visited by id, so each DragPoint keeps its ID while the curve reorders
+                const CurvePoints& fan1_curve = editableConfig.curve(0);
+                for (size_t id = 0; id < fan1_curve.size(); ++id) {
                     // Use doubles for DragPoint interaction
-                    double current_temp = static_cast<double>(fan1_plot_points[i].temp);
-                    double current_rpm = static_cast<double>(fan1_plot_points[i].rpm);
-
-                    if (ImPlot::DragPoint(i, &current_temp, &current_rpm, ImVec4(0,0.9f,0,1), 4.0f)) {
-                        // Update the upper temp and RPM from dragging
-                        fan1_plot_points[i].temp = std::max(0, std::min(127, static_cast<int>(current_temp + 0.5))); // Clamp Temp 0-127
-                        fan1_plot_points[i].rpm = std::max(0, std::min((int)FanController::MAX_FAN1_RPM, static_cast<int>(current_rpm + 0.5))); // Clamp RPM 0-Max
-
-                        // --- Automatically update the LOWER temp of the NEXT point ---
-                        size_t original_idx = fan1_plot_points[i].original_index;
-                        size_t next_lower_idx = original_idx + 1; // Index of the next point's lower bound
-
-                        // Check if the next point exists within the bounds of the lower temp array
-                        if (next_lower_idx < cpu_lower_temp_int.size()) {
-                            // Set the next point's lower temp 3 degrees below the current point's upper temp
-                            cpu_lower_temp_int[next_lower_idx] = std::max(0, fan1_plot_points[i].temp - 3);
+                    double current_temp = static_cast<double>(fan1_curve.point(id).temp);
+                    double current_rpm = static_cast<double>(fan1_curve.point(id).rpm);
+
+                    if (ImPlot::DragPoint(id, &current_temp, &current_rpm, ImVec4(0,0.9f,0,1), 4.0f)) {
+                        const int new_temp = std::max(0, std::min(127, static_cast<int>(current_temp + 0.5))); // Clamp Temp 0-127
+                        const int new_rpm = std::max(0, std::min((int)FanController::MAX_FAN1_RPM, static_cast<int>(current_rpm + 0.5))); // Clamp RPM 0-Max
+
+                        // Sets the upper temp and curve value, and the NEXT point's lower temp
+                        // (3 degrees below), then moves just this point in the sorted view
+                        size_t first_rank, last_rank;
+                        editableConfig.moveCurvePoint(0, id, new_temp, new_rpm, first_rank, last_rank);
+                        if (liveApply) {
+                            editableConfig.curvePointEntries(0, id, livePending);
+                            livePendingAny = true;
+                        }
+                        if (!fan1_plot_buffer.dirty) {
+                            fan1_plot_buffer.updateRange(fan1_curve, first_rank, last_rank);
                         }
-                        // --- End lower temp update ---
-
-                        // Ensure points remain sorted by temperature after dragging
-                        std::sort(fan1_plot_points.begin(), fan1_plot_points.end());
                     }
                 }
                 ImPlot::EndPlot();
@@ -299,40 +509,35 @@ int main(int argc, char* argv[]) {
                 ImPlot::SetupAxisLimits(ImAxis_X1, 0 - tempPadding, 127 + tempPadding); // Temp with padding
                 ImPlot::SetupAxisLimits(ImAxis_Y1, 0 - rpmPadding2, 5000 + rpmPadding2); // RPM with padding
 
-                // Prepare data for plotting
-                std::vector<double> temps_d(fan2_plot_points.size());
-                std::vector<double> rpms_d(fan2_plot_points.size());
-                 for(size_t i = 0; i < fan2_plot_points.size(); ++i) {
-                    temps_d[i] = static_cast<double>(fan2_plot_points[i].temp);
-                    rpms_d[i] = static_cast<double>(fan2_plot_points[i].rpm);
-                }
-
                 // Plot the line
-                ImPlot::PlotLine("Curve", temps_d.data(), rpms_d.data(), fan2_plot_points.size());
+                if (fan2_plot_buffer.dirty) {
+                    fan2_plot_buffer.update(editableConfig.curve(1));
+                }
+                ImPlot::PlotLine("Curve", fan2_plot_buffer.temps.data(), fan2_plot_buffer.rpms.data(), fan2_plot_buffer.size());
 
                 // Add draggable points
                 ImPlot::SetNextMarkerStyle(ImPlotMarker_Circle);
-                for (size_t i = 0; i < fan2_plot_points.size(); ++i) {
-                    double current_temp = static_cast<double>(fan2_plot_points[i].temp);
-                    double current_rpm = static_cast<double>(fan2_plot_points[i].rpm);
-
-                    if (ImPlot::DragPoint(i + fan1_plot_points.size(), &current_temp, &current_rpm, ImVec4(0,0.9f,0,1), 4.0f)) { // Ensure unique ID
-                        // Update the upper temp and RPM from dragging
-                        fan2_plot_points[i].temp = std::max(0, std::min(127, static_cast<int>(current_temp + 0.5)));
-                        fan2_plot_points[i].rpm = std::max(0, std::min((int)FanController::MAX_FAN2_RPM, static_cast<int>(current_rpm + 0.5)));
-
-                        // --- Automatically update the LOWER temp of the NEXT point ---
-                        size_t original_idx = fan2_plot_points[i].original_index;
-                        size_t next_lower_idx = original_idx + 1; // Index of the next point's lower bound
-
-                        // Check if the next point exists within the bounds of the lower temp array
-                        if (next_lower_idx < gpu_lower_temp_int.size()) {
-                             // Set the next point's lower temp 3 degrees below the current point's upper temp
-                            gpu_lower_temp_int[next_lower_idx] = std::max(0, fan2_plot_points[i].temp - 3);
+                // Points are visited by id, so each DragPoint keeps its ID while the curve reorders
+                const CurvePoints& fan2_curve = editableConfig.curve(1);
+                for (size_t id = 0; id < fan2_curve.size(); ++id) {
+                    double current_temp = static_cast<double>(fan2_curve.point(id).temp);
+                    double current_rpm = static_cast<double>(fan2_curve.point(id).rpm);
+
+                    if (ImPlot::DragPoint(id + editableConfig.curve(0).size(), &current_temp, &current_rpm, ImVec4(0,0.9f,0,1), 4.0f)) { // Ensure unique ID
+                        const int new_temp = std::max(0, std::min(127, static_cast<int>(current_temp + 0.5))); // Clamp Temp 0-127
+                        const int new_rpm = std::max(0, std::min((int)FanController::MAX_FAN2_RPM, static_cast<int>(current_rpm + 0.5))); // Clamp RPM 0-Max
+
+                        // Sets the upper temp and curve value, and the NEXT point's lower temp
+                        // (3 degrees below), then moves just this point in the sorted view
+                        size_t first_rank, last_rank;
+                        editableConfig.moveCurvePoint(1, id, new_temp, new_rpm, first_rank, last_rank);
+                        if (liveApply) {
+                            editableConfig.curvePointEntries(1, id, livePending);
+                            livePendingAny = true;
+                        }
+                        if (!fan2_plot_buffer.dirty) {
+                            fan2_plot_buffer.updateRange(fan2_curve, first_rank, last_rank);
                         }
-                        // --- End lower temp update ---
-
-                        std::sort(fan2_plot_points.begin(), fan2_plot_points.end());
                     }
                 }
                 ImPlot::EndPlot();
@@ -344,191 +549,97 @@ int main(int argc, char* argv[]) {
             ImGui::Separator();
             ImGui::Text("Acceleration/Deceleration Time (per point, 0-255)");
             // Example for Fan 1 Acc/Dec - you might want sliders for the whole vector
-            ImGui::SliderInt("Fan 1 Acc Time (P0)", &fan1_acc_time_int, 0, 255); // Example for point 0
-            ImGui::SliderInt("Fan 1 Dec Time (P0)", &fan1_dec_time_int, 0, 255); // Example for point 0
+            sliderByte("Fan 1 Acc Time (P0)", EditableConfig::ACC_TIME, 0); // Example for point 0
+            sliderByte("Fan 1 Dec Time (P0)", EditableConfig::DEC_TIME, 0); // Example for point 0
             // Add similar controls for Fan 2 and potentially other points if needed
 
             ImGui::Separator();
             if (ImGui::Button("Apply Config")) {
                 printf("--- Apply Config Button Pressed ---\n"); // Log button press
 
-                // Extract data from plot points back into the original _int vectors
-                extractDataFromPlotPoints(fan1_plot_points, cpu_upper_temp_int, fan1_curve_int);
-                extractDataFromPlotPoints(fan2_plot_points, gpu_upper_temp_int, fan2_curve_int);
-
-                // Convert back from int vectors/values to uint8_t vectors/values
-                editableConfig.fan1_curve = convertVecIntToVecU8(fan1_curve_int);
-                editableConfig.fan2_curve = convertVecIntToVecU8(fan2_curve_int);
-                editableConfig.cpu_upper_temp = convertVecIntToVecU8(cpu_upper_temp_int);
-                editableConfig.gpu_upper_temp = convertVecIntToVecU8(gpu_upper_temp_int);
-                editableConfig.cpu_lower_temp = convertVecIntToVecU8(cpu_lower_temp_int);
-                editableConfig.gpu_lower_temp = convertVecIntToVecU8(gpu_lower_temp_int);
-                // ... convert other vectors ...
-
-                 // Update acc_time/dec_time vectors
-                if (editableConfig.acc_time.size() > 0) editableConfig.acc_time[0] = static_cast<uint8_t>(fan1_acc_time_int);
-                if (editableConfig.dec_time.size() > 0) editableConfig.dec_time[0] = static_cast<uint8_t>(fan1_dec_time_int);
-                // ... update fan2 acc/dec ...
-
                 // --- Log Data Before Writing ---
-                printf("Data to be written:\n");
-                printf("  Fan1 Curve: "); for(uint8_t v : editableConfig.fan1_curve) printf("%d ", v); printf("\n");
-                printf("  Fan2 Curve: "); for(uint8_t v : editableConfig.fan2_curve) printf("%d ", v); printf("\n");
-                printf("  CPU Upper:  "); for(uint8_t v : editableConfig.cpu_upper_temp) printf("%d ", v); printf("\n");
-                printf("  CPU Lower:  "); for(uint8_t v : editableConfig.cpu_lower_temp) printf("%d ", v); printf("\n");
-                printf("  GPU Upper:  "); for(uint8_t v : editableConfig.gpu_upper_temp) printf("%d ", v); printf("\n");
-                printf("  GPU Lower:  "); for(uint8_t v : editableConfig.gpu_lower_temp) printf("%d ", v); printf("\n");
-                // Add logs for acc/dec/vrm if needed
+                // The model already holds the bytes to write; log just the entries edited since the last load/apply
+                const FanConfigData& applyConfig = editableConfig.data();
+                printf("Data to be written (%zu changed byte(s)):\n", editableConfig.dirtyCount());
+                for (int f = 0; f < EditableConfig::FIELD_COUNT; ++f) {
+                    const EditableConfig::Field field = static_cast<EditableConfig::Field>(f);
+                    const EditableConfig::DirtyMask mask = editableConfig.dirtyMask(field);
+                    if (mask == 0) continue;
+                    printf("  %-15s", EditableConfig::fieldName(field));
+                    for (size_t i = 0; i < std::tuple_size<EcTable>::value; ++i) {
+                        if (mask & (1u << i)) printf(" [%zu]=%d", i, editableConfig.get(field, i));
+                    }
+                    printf("\n");
+                }
                 printf("Attempting fanController.writeConfig...\n");
                 // --- End Log Data ---
 
-                if (fanController.writeConfig(editableConfig)) {
-                    printf("fanController.writeConfig returned TRUE.\n"); // Log success
-                    statusMessage = "Config written. Verifying...";
-
-                   // --- Verification Step ---
-                   FanStatusData verifyStatus;
-                   SDL_Delay(100); // Short delay
-                   if (fanController.readStatus(verifyStatus)) {
-                       bool verified = true;
-                       std::string verificationError = "";
-
-                       // Compare key vectors (direct comparison)
-                       if (editableConfig.fan1_curve != verifyStatus.fan1_curve) {
-                           verified = false; verificationError += " Fan1 Curve mismatch.";
-                       }
-                       if (editableConfig.fan2_curve != verifyStatus.fan2_curve) {
-                           verified = false; verificationError += " Fan2 Curve mismatch.";
-                       }
-                       if (editableConfig.cpu_upper_temp != verifyStatus.cpu_upper_temp) {
-                           verified = false; verificationError += " CPU Upper Temp mismatch.";
-                       }
-                       if (editableConfig.cpu_lower_temp != verifyStatus.cpu_lower_temp) {
-                           verified = false; verificationError += " CPU Lower Temp mismatch.";
-                       }
-                       if (editableConfig.gpu_upper_temp != verifyStatus.gpu_upper_temp) {
-                           verified = false; verificationError += " GPU Upper Temp mismatch.";
-                       }
-                       if (editableConfig.gpu_lower_temp != verifyStatus.gpu_lower_temp) {
-                           verified = false; verificationError += " GPU Lower Temp mismatch.";
-                       }
-                       // ... Add comparisons for other vectors if needed ...
-
-                       // --- Explicit Overlap Verification REMOVED ---
-                       // The direct comparison of cpu_lower_temp and gpu_lower_temp
-                       // implicitly verifies the overlap if the calculation during
-                       // drag-point was correct and the write succeeded.
-                       // --- End Overlap Verification REMOVED ---
-
-
-                       if (verified) {
-                           statusMessage = "Config written and verified successfully."; // Removed "(including overlap)"
-                           currentConfig = editableConfig;
-                           currentStatus = verifyStatus;
-                           // Optionally update plot points again from verified data
-                           // fan1_plot_points = createPlotPoints(convertVecU8ToVecInt(currentStatus.cpu_upper_temp), convertVecU8ToVecInt(currentStatus.fan1_curve));
-                           // fan2_plot_points = createPlotPoints(convertVecU8ToVecInt(currentStatus.gpu_upper_temp), convertVecU8ToVecInt(currentStatus.fan2_curve));
-                       } else {
-                           statusMessage = "Config written, but VERIFICATION FAILED:" + verificationError;
-                           printf("--- VERIFICATION FAILED ---\n");
-                           printf("Verification Error Details: %s\n", verificationError.c_str()); // Print the specific error message
-
-                           printf("Expected Fan1 Curve: "); for(uint8_t v : editableConfig.fan1_curve) printf("%d ", v); printf("\n");
-                           printf("Actual Fan1 Curve:   "); for(uint8_t v : verifyStatus.fan1_curve) printf("%d ", v); printf("\n");
-
-                           printf("Expected Fan2 Curve: "); for(uint8_t v : editableConfig.fan2_curve) printf("%d ", v); printf("\n");
-                           printf("Actual Fan2 Curve:   "); for(uint8_t v : verifyStatus.fan2_curve) printf("%d ", v); printf("\n");
-
-                           printf("Expected CPU Upper: "); for(uint8_t v : editableConfig.cpu_upper_temp) printf("%d ", v); printf("\n");
-                           printf("Actual CPU Upper:   "); for(uint8_t v : verifyStatus.cpu_upper_temp) printf("%d ", v); printf("\n");
-
-                           printf("Expected CPU Lower: "); for(uint8_t v : editableConfig.cpu_lower_temp) printf("%d ", v); printf("\n");
-                           printf("Actual CPU Lower:   "); for(uint8_t v : verifyStatus.cpu_lower_temp) printf("%d ", v); printf("\n");
-
-                           printf("Expected GPU Upper: "); for(uint8_t v : editableConfig.gpu_upper_temp) printf("%d ", v); printf("\n");
-                           printf("Actual GPU Upper:   "); for(uint8_t v : verifyStatus.gpu_upper_temp) printf("%d ", v); printf("\n");
-
-                           printf("Expected GPU Lower: "); for(uint8_t v : editableConfig.gpu_lower_temp) printf("%d ", v); printf("\n");
-                           printf("Actual GPU Lower:   "); for(uint8_t v : verifyStatus.gpu_lower_temp) printf("%d ", v); printf("\n");
-                       }
-                       printf("---------------------------\n"); // Log end of verification
-                   } else {
-                    statusMessage = "Config written, but failed to read back for verification: " + fanController.getLastError();
-                  }
+                // Hand the write to the EC worker; the result arrives via pollResult
+                const VerifyMode verifyMode = liveSentSinceApply ? VerifyMode::AllTables : VerifyMode::WrittenBytes;
+                if (ecWorker.submitApply(applyConfig, EcPriority::Bulk, EC_NO_DEADLINE, verifyMode)) {
+                    liveSentSinceApply = false;
+                    // Edits made while this apply is in flight stay dirty on their own; the ones
+                    // handed over (here or by an earlier apply still unconfirmed) come back if it fails
+                    editableConfig.takeDirty(pendingApplyDirty);
+                    statusMessage = "Applying config...";
                 } else {
-                    // Log failure and the error message
-                    printf("fanController.writeConfig returned FALSE.\n");
-                    statusMessage = "Error writing config: " + fanController.getLastError();
-                    printf("Error details: %s\n", fanController.getLastError().c_str());
+                    statusMessage = "EC worker busy, config not applied. Try again.";
+                    printf("--- Apply Config Action Finished (worker queue full) ---\n");
                 }
-                 printf("--- Apply Config Action Finished ---\n"); // Log end of action
             }
 
             ImGui::SameLine();
 
             if (ImGui::Button("Reload Config")) {
-                 // Re-read status which contains the current config
-                if (fanController.readStatus(currentStatus)) {
-                    statusMessage = "Config reloaded from EC.";
-
-                        // --- DEBUG: Print raw data from readStatus ---
-                        printf("--- Reloading ---\n");
-                        printf("Raw Fan 1 Curve (readStatus): ");
-                        for(uint8_t val : currentStatus.fan1_curve) { printf("%d ", val); } printf("\n");
-                        printf("Raw CPU Upper Temp (readStatus): ");
-                        for(uint8_t val : currentStatus.cpu_upper_temp) { printf("%d ", val); } printf("\n");
-                        printf("Raw Fan 2 Curve (readStatus): ");
-                        for(uint8_t val : currentStatus.fan2_curve) { printf("%d ", val); } printf("\n");
-                        printf("Raw GPU Upper Temp (readStatus): ");
-                        for(uint8_t val : currentStatus.gpu_upper_temp) { printf("%d ", val); } printf("\n");
-                        // --- END DEBUG ---
-
-
-                        // Copy config parts from status to editableConfig
-                        editableConfig.fan1_curve = currentStatus.fan1_curve;
-                        editableConfig.fan2_curve = currentStatus.fan2_curve;
-                        editableConfig.acc_time = currentStatus.acc_time;
-                        editableConfig.dec_time = currentStatus.dec_time;
-                        editableConfig.cpu_lower_temp = currentStatus.cpu_lower_temp;
-                        editableConfig.cpu_upper_temp = currentStatus.cpu_upper_temp;
-                        editableConfig.gpu_lower_temp = currentStatus.gpu_lower_temp;
-                        editableConfig.gpu_upper_temp = currentStatus.gpu_upper_temp;
-                        editableConfig.vrm_lower_temp = currentStatus.vrm_lower_temp;
-                        editableConfig.vrm_upper_temp = currentStatus.vrm_upper_temp;
-
-                        // Update int versions for ImGui controls (sliders, plots, etc.)
-                        fan1_curve_int = convertVecU8ToVecInt(editableConfig.fan1_curve);
-                        fan2_curve_int = convertVecU8ToVecInt(editableConfig.fan2_curve);
-                        cpu_upper_temp_int = convertVecU8ToVecInt(editableConfig.cpu_upper_temp);
-                        gpu_upper_temp_int = convertVecU8ToVecInt(editableConfig.gpu_upper_temp);
-                        cpu_lower_temp_int = convertVecU8ToVecInt(editableConfig.cpu_lower_temp);
-                        gpu_lower_temp_int = convertVecU8ToVecInt(editableConfig.gpu_lower_temp);
-                        // ... update other int vectors/values ...
-                        fan1_acc_time_int = (editableConfig.acc_time.size() > 0) ? editableConfig.acc_time[0] : 0;
-                        fan1_dec_time_int = (editableConfig.dec_time.size() > 0) ? editableConfig.dec_time[0] : 0;
-                        // ... update fan2 acc/dec ...
-
-                        // Update plot points from the reloaded config
-                        fan1_plot_points = createPlotPoints(cpu_upper_temp_int, fan1_curve_int);
-                        fan2_plot_points = createPlotPoints(gpu_upper_temp_int, fan2_curve_int);
-
-                        // --- DEBUG: Print generated plot points ---
-                        printf("Generated Fan 1 Plot Points (Temp, RPM): ");
-                        for(const auto& p : fan1_plot_points) { printf("(%d, %d) ", p.temp, p.rpm); } printf("\n");
-                        printf("Generated Fan 2 Plot Points (Temp, RPM): ");
-                        for(const auto& p : fan2_plot_points) { printf("(%d, %d) ", p.temp, p.rpm); } printf("\n");
-                        printf("-----------------\n");
-                        // --- END DEBUG ---
-
+                 // Re-read status which contains the current config (handled when the result arrives)
+                if (ecWorker.submitReload()) {
+                    statusMessage = "Reloading config from EC...";
                 } else {
-                    statusMessage = "Error reloading config from EC: " + fanController.getLastError();
+                    statusMessage = "EC worker busy, reload not queued. Try again.";
                 }
             }
 
+            // Streams each dragged point's bytes (no verification); Apply Config still writes
+            // and verifies the whole config
+            if (ImGui::Checkbox("Live apply while dragging", &liveApply) && !liveApply) {
+                livePending = ConfigEntryMask();
+                livePendingAny = false;
+            }
+            ImGui::SameLine();
+            ImGui::SliderInt("Min interval (ms)", &liveApplyIntervalMs, 10, 500);
+
         } else {
             ImGui::Text("Fan controller not initialized. Check status message.");
         }
 
+        // --- Display / Tray ---
+        ImGui::Separator();
+        ImGui::Checkbox("On-demand rendering", &onDemandRendering);
+        ImGui::SliderInt("Tray poll interval (ms)", &trayPollIntervalMs, 250, 5000);
+        if (ImGui::Button("Hide to Tray")) {
+            tray = SDL_CreateTray(nullptr, "Fan Control");
+            if (tray != nullptr) {
+                SDL_TrayMenu* trayMenu = SDL_CreateTrayMenu(tray);
+                SDL_TrayEntry* showEntry = SDL_InsertTrayEntryAt(trayMenu, -1, "Show", SDL_TRAYENTRY_BUTTON);
+                SDL_TrayEntry* quitEntry = SDL_InsertTrayEntryAt(trayMenu, -1, "Quit", SDL_TRAYENTRY_BUTTON);
+                SDL_SetTrayEntryCallback(showEntry, [](void* userdata, SDL_TrayEntry*) {
+                    TrayRequests* requests = static_cast<TrayRequests*>(userdata);
+                    requests->show = true;
+                    requests->wake();
+                }, &trayRequests);
+                SDL_SetTrayEntryCallback(quitEntry, [](void* userdata, SDL_TrayEntry*) {
+                    TrayRequests* requests = static_cast<TrayRequests*>(userdata);
+                    requests->quit = true;
+                    requests->wake();
+                }, &trayRequests);
+                SDL_HideWindow(window);
+            } else {
+                // No tray on this desktop; minimizing gives the same no-render, slow-poll mode
+                printf("SDL_CreateTray failed (%s), minimizing instead.\n", SDL_GetError());
+                SDL_MinimizeWindow(window);
+            }
+        }
+
         // Rendering
         ImGui::Render();
         //SDL_RenderSetScale(renderer, io.DisplayFramebufferScale.x, io.DisplayFramebufferScale.y);
@@ -536,10 +647,17 @@ int main(int argc, char* argv[]) {
         SDL_RenderClear(renderer);
         ImGui_ImplSDLRenderer3_RenderDrawData(ImGui::GetDrawData(), renderer);
         SDL_RenderPresent(renderer);
+        if (framesToRender > 0) {
+            --framesToRender;
+        }
     }
 
 
     // Cleanup
+    ecWorker.stop(); // Joins the EC thread and deinitializes the controller
+    if (tray != nullptr) {
+        SDL_DestroyTray(tray);
+    }
     ImGui_ImplSDLRenderer3_Shutdown();
     ImGui_ImplSDL3_Shutdown();
     ImPlot::DestroyContext(); // Destroy ImPlot context
@@ -0,0 +1,634 @@
+#include "port_backend.h"
+#include "ec_protocol.h"
+#include <algorithm>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#endif
+#ifdef FAN_CONTROL_HAS_IOPERM
+#include <sys/io.h>
+#endif
+#ifdef FAN_CONTROL_HAS_DEV_PORT
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#define FAN_CONTROL_HAS_IO_URING 1
+#endif
+#endif
+#if defined(FAN_CONTROL_HAS_IOPERM) || defined(FAN_CONTROL_HAS_DEV_PORT)
+#include <cerrno>
+#include <cstring>
+#endif
+
+std::unique_ptr<PortBackend> createDefaultPortBackend() {
+    const char* selected = std::getenv("FAN_CONTROL_BACKEND");
+    if (selected != nullptr && selected[0] != '\0') {
+        return createPortBackend(selected);
+    }
+#if defined(_WIN32)
+    return std::unique_ptr<PortBackend>(new WinRing0PortBackend());
+#elif defined(FAN_CONTROL_HAS_IOPERM)
+    // ioperm needs CAP_SYS_RAWIO and is refused under some lockdown setups; /dev/port may still work
+    return std::unique_ptr<PortBackend>(new FallbackPortBackend(std::unique_ptr<PortBackend>(new IopermPortBackend()),
+                                                                std::unique_ptr<PortBackend>(new DevPortBackend())));
+#else
+    return nullptr;
+#endif
+}
+
+std::unique_ptr<PortBackend> createPortBackend(const std::string& name) {
+#ifdef _WIN32
+    if (name == "winring0") return std::unique_ptr<PortBackend>(new WinRing0PortBackend());
+#endif
+#ifdef FAN_CONTROL_HAS_IOPERM
+    if (name == "ioperm") return std::unique_ptr<PortBackend>(new IopermPortBackend());
+#endif
+#ifdef FAN_CONTROL_HAS_DEV_PORT
+    if (name == "dev-port") return std::unique_ptr<PortBackend>(new DevPortBackend());
+#endif
+    if (name == "simulator") return std::unique_ptr<PortBackend>(new SimulatedEcPortBackend());
+    return nullptr;
+}
+
+// --- Fallback Chain ---
+
+FallbackPortBackend::FallbackPortBackend(std::unique_ptr<PortBackend> primary, std::unique_ptr<PortBackend> fallback) {
+    candidates[0] = std::move(primary);
+    candidates[1] = std::move(fallback);
+    active = candidates[0].get();
+}
+
+bool FallbackPortBackend::open(std::string& error) {
+    std::string errors;
+    for (std::unique_ptr<PortBackend>& candidate : candidates) {
+        std::string candidateError;
+        if (candidate->open(candidateError)) {
+            active = candidate.get();
+            return true;
+        }
+        errors += (errors.empty() ? "" : " ") + std::string(candidate->name()) + ": " + candidateError;
+    }
+    error = errors;
+    return false;
+}
+
+void FallbackPortBackend::close() {
+    active->close();
+}
+
+// --- WinRing0 Backend ---
+#ifdef _WIN32
+
+namespace {
+    // ACPI EC status/command port and its input buffer full (IBF) bit
+    const uint16_t EC_STATUS_PORT = 0x66;
+    const uint8_t EC_STATUS_IBF = 0x02;
+}
+
+WinRing0PortBackend::WinRing0PortBackend() {}
+
+WinRing0PortBackend::~WinRing0PortBackend() {
+    close();
+}
+
+void WinRing0PortBackend::unload() {
+    if (hWinRing0Wrapper) {
+        FreeLibrary((HMODULE)hWinRing0Wrapper);
+        hWinRing0Wrapper = nullptr;
+    }
+    // Reset pointers
+    pLoadWinRing0 = nullptr;
+    pInitWinRing0 = nullptr;
+    pReadPort = nullptr;
+    pWritePort = nullptr;
+    pGetStatus = nullptr;
+    pDeinitWinRing0 = nullptr;
+    pEcReadRange = nullptr;
+    pEcWriteRange = nullptr;
+    pExecutePortProgram = nullptr;
+    pSetEcReadyCheck = nullptr;
+    pSetEcWaitPolicy = nullptr;
+    pGetEcWaitHistogram = nullptr;
+}
+
+bool WinRing0PortBackend::open(std::string& error) {
+    if (initialized) {
+        return true; // Already initialized
+    }
+
+    // Use LoadLibraryA for ANSI compatibility if needed, or LoadLibraryW for Unicode
+    hWinRing0Wrapper = LoadLibraryA("winring_wrapper.dll");
+    if (!hWinRing0Wrapper) {
+        DWORD errorCode = GetLastError();
+        error = "Could not load winring_wrapper.dll. Error code: " + std::to_string(errorCode) + ". Ensure DLL and dependencies (WinRing0x64.dll, MinGW runtimes) are present.";
+        return false;
+    }
+
+    // Get function pointers
+    pLoadWinRing0 = (LoadWinRing0_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "LoadWinRing0");
+    pInitWinRing0 = (InitWinRing0_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "InitWinRing0");
+    pReadPort = (ReadPort_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "ReadPort");
+    pWritePort = (WritePort_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "WritePort");
+    pGetStatus = (GetStatus_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "GetStatus");
+    pDeinitWinRing0 = (DeinitWinRing0_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "DeinitWinRing0");
+    // Batched exports are optional so older wrapper DLLs keep working on the per-op path
+    pEcReadRange = (EcReadRange_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "EcReadRange");
+    pEcWriteRange = (EcWriteRange_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "EcWriteRange");
+    pExecutePortProgram = (ExecutePortProgram_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "ExecutePortProgram");
+    pSetEcReadyCheck = (SetEcReadyCheck_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "SetEcReadyCheck");
+    pSetEcWaitPolicy = (SetEcWaitPolicy_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "SetEcWaitPolicy");
+    pGetEcWaitHistogram = (GetEcWaitHistogram_t)GetProcAddress((HMODULE)hWinRing0Wrapper, "GetEcWaitHistogram");
+
+    if (!pLoadWinRing0 || !pInitWinRing0 || !pReadPort || !pWritePort || !pGetStatus || !pDeinitWinRing0) {
+        error = "Could not get one or more function addresses from wrapper DLL.";
+        unload();
+        return false;
+    }
+
+    if (!pLoadWinRing0()) {
+        error = "LoadWinRing0() via wrapper failed.";
+        unload();
+        return false;
+    }
+
+    if (!pInitWinRing0()) {
+        uint32_t status = pGetStatus ? pGetStatus() : 0;
+        error = "InitWinRing0() via wrapper failed. Status: " + std::to_string(status);
+        // Don't call deinit here as init failed, just free library
+        unload();
+        return false;
+    }
+
+    initialized = true;
+    return true;
+}
+
+void WinRing0PortBackend::close() {
+    if (hWinRing0Wrapper && initialized && pDeinitWinRing0) {
+        pDeinitWinRing0();
+    }
+    unload();
+    initialized = false;
+}
+
+uint8_t WinRing0PortBackend::readPort(uint16_t port) {
+    return pReadPort ? pReadPort(port) : 0;
+}
+
+void WinRing0PortBackend::writePort(uint16_t port, uint8_t value) {
+    if (pWritePort) {
+        pWritePort(port, value);
+    }
+}
+
+bool WinRing0PortBackend::ecReadRange(uint16_t addr, uint8_t* out, size_t len) {
+    return pEcReadRange && pEcReadRange(addr, len, out) != 0;
+}
+
+bool WinRing0PortBackend::ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) {
+    return pEcWriteRange && pEcWriteRange(addr, data, len) != 0;
+}
+
+bool WinRing0PortBackend::executePortProgram(const ec_protocol::PortOp* ops, size_t count, uint8_t* results) {
+    return pExecutePortProgram && pExecutePortProgram(ops, count, results) == count;
+}
+
+bool WinRing0PortBackend::setWaitPolicy(const EcWaitPolicy& policy) {
+    if (!pSetEcWaitPolicy || !pSetEcReadyCheck) {
+        return false;
+    }
+    // The export treats 0 as "keep the current value", so clamp each phase to at least 1 unit
+    const auto atLeastOne = [](int64_t count) { return static_cast<uint32_t>(count < 1 ? 1 : count); };
+    pSetEcWaitPolicy(atLeastOne(policy.spin_budget.count()), atLeastOne(policy.yield_budget.count()),
+                     atLeastOne(policy.timeout.count()));
+    if (policy.ready_check) {
+        pSetEcReadyCheck(EC_STATUS_PORT, EC_STATUS_IBF, 0x00); // Wait for the EC input buffer to drain
+    } else {
+        pSetEcReadyCheck(0, 0, 0);
+    }
+    return true;
+}
+
+bool WinRing0PortBackend::waitHistogram(EcWaitHistogram& out, bool reset) {
+    return pGetEcWaitHistogram && pGetEcWaitHistogram(&out, reset ? 1 : 0) != 0;
+}
+
+#endif // _WIN32
+
+// --- Linux ioperm Backend ---
+#ifdef FAN_CONTROL_HAS_IOPERM
+
+namespace {
+    // glibc's inb/outb are inline asm; note outb takes (value, port)
+    struct InlinePortIo {
+        void in(uint16_t port, uint8_t* dst) { *dst = inb(port); }
+        void out(uint16_t port, uint8_t value) { outb(value, port); }
+    };
+}
+
+IopermPortBackend::~IopermPortBackend() {
+    close();
+}
+
+bool IopermPortBackend::open(std::string& error) {
+    if (granted) {
+        return true;
+    }
+    if (ioperm(ec_protocol::SIO_INDEX_PORT, 2, 1) != 0) {
+        error = std::string("ioperm(0x4E, 2, 1) failed: ") + std::strerror(errno) + ". Run as root or grant CAP_SYS_RAWIO.";
+        return false;
+    }
+    granted = true;
+    return true;
+}
+
+void IopermPortBackend::close() {
+    if (granted) {
+        ioperm(ec_protocol::SIO_INDEX_PORT, 2, 0);
+        granted = false;
+    }
+}
+
+uint8_t IopermPortBackend::readPort(uint16_t port) {
+    return inb(port);
+}
+
+void IopermPortBackend::writePort(uint16_t port, uint8_t value) {
+    outb(value, port);
+}
+
+bool IopermPortBackend::ecReadRange(uint16_t addr, uint8_t* out, size_t len) {
+    InlinePortIo io;
+    ec_protocol::readRange(io, addr, out, len);
+    return true;
+}
+
+bool IopermPortBackend::ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) {
+    InlinePortIo io;
+    ec_protocol::writeRange(io, addr, data, len);
+    return true;
+}
+
+#endif // FAN_CONTROL_HAS_IOPERM
+
+// --- Linux /dev/port Backend ---
+#ifdef FAN_CONTROL_HAS_DEV_PORT
+
+#ifdef FAN_CONTROL_HAS_IO_URING
+// Minimal raw-syscall io_uring: one SQ/CQ pair sized for a few EC table sweeps per submit
+struct DevPortBackend::Ring {
+    static const unsigned ENTRIES = 256;
+
+    int fd = -1;
+    void* sq_ptr = MAP_FAILED;
+    size_t sq_size = 0;
+    void* cq_ptr = MAP_FAILED;
+    size_t cq_size = 0;
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqes_size = 0;
+
+    unsigned* sq_tail = nullptr;
+    unsigned* sq_mask = nullptr;
+    unsigned* sq_array = nullptr;
+    unsigned* cq_head = nullptr;
+    unsigned* cq_tail = nullptr;
+    unsigned* cq_mask = nullptr;
+    io_uring_cqe* cqes = nullptr;
+
+    bool setup() {
+        io_uring_params params;
+        std::memset(&params, 0, sizeof(params));
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, ENTRIES, &params));
+        if (fd < 0) {
+            return false;
+        }
+
+        sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cq_size = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        const bool single_mmap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (single_mmap) {
+            sq_size = cq_size = (sq_size > cq_size) ? sq_size : cq_size;
+        }
+
+        sq_ptr = mmap(nullptr, sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sq_ptr == MAP_FAILED) {
+            return false;
+        }
+        if (single_mmap) {
+            cq_ptr = sq_ptr;
+        } else {
+            cq_ptr = mmap(nullptr, cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+            if (cq_ptr == MAP_FAILED) {
+                return false;
+            }
+        }
+        sqes_size = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED) {
+            return false;
+        }
+
+        char* sq = static_cast<char*>(sq_ptr);
+        char* cq = static_cast<char*>(cq_ptr);
+        sq_tail = reinterpret_cast<unsigned*>(sq + params.sq_off.tail);
+        sq_mask = reinterpret_cast<unsigned*>(sq + params.sq_off.ring_mask);
+        sq_array = reinterpret_cast<unsigned*>(sq + params.sq_off.array);
+        cq_head = reinterpret_cast<unsigned*>(cq + params.cq_off.head);
+        cq_tail = reinterpret_cast<unsigned*>(cq + params.cq_off.tail);
+        cq_mask = reinterpret_cast<unsigned*>(cq + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(cq + params.cq_off.cqes);
+        return true;
+    }
+
+    ~Ring() {
+        if (sqes != MAP_FAILED) munmap(sqes, sqes_size);
+        if (cq_ptr != MAP_FAILED && cq_ptr != sq_ptr) munmap(cq_ptr, cq_size);
+        if (sq_ptr != MAP_FAILED) munmap(sq_ptr, sq_size);
+        if (fd >= 0) ::close(fd);
+    }
+};
+#else
+struct DevPortBackend::Ring {};
+#endif // FAN_CONTROL_HAS_IO_URING
+
+struct DevPortBackend::BatchIo {
+    DevPortBackend* backend;
+    void in(uint16_t port, uint8_t* dst) { backend->batch.push_back({ true, port, 0, dst }); }
+    void out(uint16_t port, uint8_t value) { backend->batch.push_back({ false, port, value, nullptr }); }
+};
+
+DevPortBackend::DevPortBackend(const std::string& devicePath) : path(devicePath) {}
+
+DevPortBackend::~DevPortBackend() {
+    close();
+}
+
+bool DevPortBackend::open(std::string& error) {
+    if (fd >= 0) {
+        return true;
+    }
+    fd = ::open(path.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        error = "Could not open " + path + ": " + std::strerror(errno) + ".";
+        return false;
+    }
+    struct stat st;
+    stand_in = fstat(fd, &st) == 0 && S_ISREG(st.st_mode);
+    batch.reserve(512);
+#ifdef FAN_CONTROL_HAS_IO_URING
+    std::unique_ptr<Ring> candidate(new Ring());
+    if (candidate->setup()) {
+        ring = std::move(candidate);
+    }
+    // No io_uring (old kernel, seccomp, sysctl): stay on plain pread/pwrite
+#endif
+    resetCounters();
+    return true;
+}
+
+void DevPortBackend::close() {
+    ring.reset();
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+}
+
+void DevPortBackend::resetCounters() {
+    syscall_count = 0;
+    port_op_count = 0;
+}
+
+uint8_t DevPortBackend::readPort(uint16_t port) {
+    uint8_t value = 0xFF;
+    ++syscall_count;
+    ++port_op_count;
+    if (pread(fd, &value, 1, port) != 1) {
+        return 0xFF;
+    }
+    return value;
+}
+
+void DevPortBackend::writePort(uint16_t port, uint8_t value) {
+    ++syscall_count;
+    ++port_op_count;
+    (void)!pwrite(fd, &value, 1, port);
+}
+
+bool DevPortBackend::ecReadRange(uint16_t addr, uint8_t* out, size_t len) {
+    if (!ring) {
+        return false;
+    }
+    batch.clear();
+    BatchIo io = { this };
+    ec_protocol::readRange(io, addr, out, len);
+    return submitBatch();
+}
+
+bool DevPortBackend::ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) {
+    if (!ring) {
+        return false;
+    }
+    batch.clear();
+    BatchIo io = { this };
+    ec_protocol::writeRange(io, addr, data, len);
+    return submitBatch();
+}
+
+bool DevPortBackend::executePortProgram(const ec_protocol::PortOp* ops, size_t count, uint8_t* results) {
+    if (!ring) {
+        return false;
+    }
+    batch.clear();
+    size_t read_index = 0;
+    for (size_t i = 0; i < count; ++i) {
+        if (ops[i].is_read) {
+            batch.push_back({ true, ops[i].port, 0, &results[read_index++] });
+        } else {
+            batch.push_back({ false, ops[i].port, ops[i].value, nullptr });
+        }
+    }
+    return submitBatch();
+}
+
+// Replays the queued ops one syscall at a time (used if the ring fails mid-batch)
+void DevPortBackend::runBatchSync() {
+    for (PendingOp& op : batch) {
+        if (op.is_read) {
+            *op.dst = readPort(op.port);
+        } else {
+            writePort(op.port, op.value);
+        }
+    }
+}
+
+// Submits the queued ops as chains of linked SQEs, one io_uring_enter per ring-full.
+// IOSQE_IO_LINK makes each op start only after the previous one completed, preserving the
+// index/data ordering the SuperIO protocol depends on.
+bool DevPortBackend::submitBatch() {
+#ifdef FAN_CONTROL_HAS_IO_URING
+    port_op_count += batch.size();
+    size_t next = 0;
+    while (next < batch.size()) {
+        const size_t chunk = std::min(batch.size() - next, static_cast<size_t>(Ring::ENTRIES));
+        unsigned tail = *ring->sq_tail;
+        const unsigned mask = *ring->sq_mask;
+        for (size_t i = 0; i < chunk; ++i) {
+            PendingOp& op = batch[next + i];
+            const unsigned index = tail & mask;
+            io_uring_sqe* sqe = &ring->sqes[index];
+            std::memset(sqe, 0, sizeof(*sqe));
+            sqe->opcode = op.is_read ? IORING_OP_READ : IORING_OP_WRITE;
+            sqe->fd = fd;
+            sqe->addr = reinterpret_cast<uint64_t>(op.is_read ? op.dst : &op.value);
+            sqe->len = 1;
+            sqe->off = op.port;
+            sqe->flags = (i + 1 < chunk) ? IOSQE_IO_LINK : 0;
+            sqe->user_data = next + i;
+            ring->sq_array[index] = index;
+            ++tail;
+        }
+        __atomic_store_n(ring->sq_tail, tail, __ATOMIC_RELEASE);
+
+        // Reap every completion of this chunk, re-entering only if the first wait came up short
+        size_t reaped = 0;
+        bool failed = false;
+        unsigned to_submit = static_cast<unsigned>(chunk);
+        while (reaped < chunk) {
+            ++syscall_count;
+            const long rc = syscall(__NR_io_uring_enter, ring->fd, to_submit, static_cast<unsigned>(chunk - reaped),
+                                    IORING_ENTER_GETEVENTS, nullptr, 0);
+            if (rc < 0 && errno != EINTR) {
+                failed = true;
+                break;
+            }
+            if (rc > 0) {
+                to_submit -= static_cast<unsigned>(rc);
+            }
+            unsigned head = *ring->cq_head;
+            const unsigned cq_tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+            while (head != cq_tail) {
+                if (ring->cqes[head & *ring->cq_mask].res != 1) {
+                    failed = true;
+                }
+                ++head;
+                ++reaped;
+            }
+            __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+        }
+
+        if (failed) {
+            // A broken link cancels the rest of the chain. Drop to plain syscalls for good and
+            // redo the whole range so the latch ends where the caller expects it.
+            ring.reset();
+            runBatchSync();
+            return true;
+        }
+        next += chunk;
+    }
+    return true;
+#else
+    runBatchSync();
+    return true;
+#endif
+}
+
+#endif // FAN_CONTROL_HAS_DEV_PORT
+
+// --- Simulated ITE EC Backend ---
+
+SimulatedEcPortBackend::SimulatedEcPortBackend() : ec_ram(0x10000, 0) {}
+
+bool SimulatedEcPortBackend::open(std::string& error) {
+    (void)error;
+    is_open = true;
+    return true;
+}
+
+void SimulatedEcPortBackend::close() {
+    is_open = false;
+}
+
+void SimulatedEcPortBackend::setLatency(std::chrono::nanoseconds latency) {
+    op_latency = latency;
+}
+
+// Busy-waits instead of sleeping: real port ops are sub-millisecond, far below sleep granularity
+void SimulatedEcPortBackend::spendLatency() const {
+    if (op_latency.count() <= 0) {
+        return;
+    }
+    const auto deadline = std::chrono::steady_clock::now() + op_latency;
+    while (std::chrono::steady_clock::now() < deadline) {
+    }
+}
+
+uint8_t SimulatedEcPortBackend::readPort(uint16_t port) {
+    ++port_reads;
+    spendLatency();
+    if (!is_open) {
+        return 0xFF; // Floating bus
+    }
+    if (port == SIO_INDEX_PORT) {
+        return sio_index;
+    }
+    if (port != SIO_DATA_PORT) {
+        return 0xFF;
+    }
+
+    if (sio_index == 0x2E) {
+        return d2_index;
+    }
+    if (sio_index == 0x2F) {
+        switch (d2_index) {
+        case 0x10: return addr_lo;
+        case 0x11: return addr_hi;
+        case 0x12: return ec_ram[ecAddress()];
+        default: return 0xFF;
+        }
+    }
+    return 0xFF;
+}
+
+void SimulatedEcPortBackend::writePort(uint16_t port, uint8_t value) {
+    ++port_writes;
+    spendLatency();
+    if (!is_open) {
+        return;
+    }
+    if (port == SIO_INDEX_PORT) {
+        sio_index = value;
+        return;
+    }
+    if (port != SIO_DATA_PORT) {
+        return;
+    }
+
+    if (sio_index == 0x2E) {
+        d2_index = value;
+    } else if (sio_index == 0x2F) {
+        switch (d2_index) {
+        case 0x10: addr_lo = value; break;
+        case 0x11: addr_hi = value; break;
+        case 0x12: ec_ram[ecAddress()] = value; break;
+        default: break;
+        }
+    }
+}
+
+uint8_t SimulatedEcPortBackend::peek(uint16_t addr) const {
+    return ec_ram[addr];
+}
+
+void SimulatedEcPortBackend::poke(uint16_t addr, uint8_t value) {
+    ec_ram[addr] = value;
+}
+
+void SimulatedEcPortBackend::resetCounters() {
+    port_reads = 0;
+    port_writes = 0;
+}
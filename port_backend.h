@@ -0,0 +1,287 @@
+#ifndef PORT_BACKEND_H
+#define PORT_BACKEND_H
+
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ec_protocol.h"
+#include "ec_wait.h"
+
+#if defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#define FAN_CONTROL_HAS_IOPERM 1
+#endif
+#if defined(__linux__)
+#define FAN_CONTROL_HAS_DEV_PORT 1
+#endif
+
+// Byte-wide x86 I/O port access used by FanController. Implementations wrap whatever
+// mechanism the platform offers (WinRing0 on Windows, ioperm on Linux, a simulator anywhere).
+class PortBackend {
+public:
+    virtual ~PortBackend() {}
+
+    // Acquires port access. On failure returns false and describes why in error.
+    virtual bool open(std::string& error) = 0;
+
+    // Releases port access. Safe to call when not open.
+    virtual void close() = 0;
+
+    virtual uint8_t readPort(uint16_t port) = 0;
+    virtual void writePort(uint16_t port, uint8_t value) = 0;
+
+    // Optional bulk EC RAM access that runs the whole SuperIO index/data sequence inside the
+    // backend (see ec_protocol.h). Returns false if unsupported, in which case FanController
+    // falls back to readPort/writePort. On success the D2EC latch is left on the last byte
+    // with the data register selected.
+    virtual bool ecReadRange(uint16_t addr, uint8_t* out, size_t len) {
+        (void)addr; (void)out; (void)len;
+        return false;
+    }
+    virtual bool ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) {
+        (void)addr; (void)data; (void)len;
+        return false;
+    }
+
+    // Optional: runs a whole list of port ops in one call, in order. Each read stores its value
+    // in the next slot of results (one byte per read op). Returns false if unsupported, in
+    // which case FanController issues the ops through the range or single-op calls.
+    virtual bool executePortProgram(const ec_protocol::PortOp* ops, size_t count, uint8_t* results) {
+        (void)ops; (void)count; (void)results;
+        return false;
+    }
+
+    // Optional EC ready-wait tuning and statistics for backends that can poll a ready bit
+    // before each port op (see ec_wait.h); policy.ready_check turns the wait on or off. Both
+    // return false if the backend cannot wait.
+    virtual bool setWaitPolicy(const EcWaitPolicy& policy) {
+        (void)policy;
+        return false;
+    }
+    virtual bool waitHistogram(EcWaitHistogram& out, bool reset) {
+        (void)out; (void)reset;
+        return false;
+    }
+
+    // Whether FanController must hold the machine-wide EC lock (ec_lock.h) around port access.
+    // True for anything that reaches real ports; false for stand-ins such as the simulator.
+    virtual bool needsSystemLock() const { return true; }
+
+    // Short human-readable backend name for status messages
+    virtual const char* name() const = 0;
+};
+
+// Returns the backend named by the FAN_CONTROL_BACKEND environment variable if it is set
+// (see createPortBackend), otherwise the default for this platform (WinRing0 on Windows,
+// ioperm falling back to /dev/port on x86 Linux). Returns nullptr if there is none.
+std::unique_ptr<PortBackend> createDefaultPortBackend();
+
+// Creates a backend by name: "winring0", "ioperm", "dev-port" or "simulator". Returns nullptr if the
+// name is unknown or the backend is not available in this build.
+std::unique_ptr<PortBackend> createPortBackend(const std::string& name);
+
+// Tries each backend in order on open() and forwards everything to the first one that opens,
+// e.g. ioperm with /dev/port behind it for hosts where ioperm is denied
+class FallbackPortBackend : public PortBackend {
+public:
+    FallbackPortBackend(std::unique_ptr<PortBackend> primary, std::unique_ptr<PortBackend> fallback);
+
+    bool open(std::string& error) override;
+    void close() override;
+    uint8_t readPort(uint16_t port) override { return active->readPort(port); }
+    void writePort(uint16_t port, uint8_t value) override { active->writePort(port, value); }
+    bool ecReadRange(uint16_t addr, uint8_t* out, size_t len) override { return active->ecReadRange(addr, out, len); }
+    bool ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) override { return active->ecWriteRange(addr, data, len); }
+    bool executePortProgram(const ec_protocol::PortOp* ops, size_t count, uint8_t* results) override {
+        return active->executePortProgram(ops, count, results);
+    }
+    bool setWaitPolicy(const EcWaitPolicy& policy) override { return active->setWaitPolicy(policy); }
+    bool waitHistogram(EcWaitHistogram& out, bool reset) override { return active->waitHistogram(out, reset); }
+    bool needsSystemLock() const override { return active->needsSystemLock(); }
+    const char* name() const override { return active->name(); }
+
+private:
+    std::unique_ptr<PortBackend> candidates[2];
+    PortBackend* active; // Primary until a fallback opens
+};
+
+#ifdef _WIN32
+// Talks to the EC through winring_wrapper.dll (ReadPort/WritePort exports). Range ops use the
+// wrapper's EcReadRange/EcWriteRange exports when the loaded DLL has them, so a whole table
+// costs one cross-module call instead of one per port op, and ExecutePortProgram runs any
+// other op list (scattered reads, several write runs) the same way. When the DLL has SetEcReadyCheck,
+// setWaitPolicy with ready_check set turns on the wait for the ACPI EC input buffer (port 0x66
+// IBF clear) before each op; it is off by default and the DLL drops it after repeated timeouts.
+class WinRing0PortBackend : public PortBackend {
+public:
+    WinRing0PortBackend();
+    ~WinRing0PortBackend() override;
+
+    bool open(std::string& error) override;
+    void close() override;
+    uint8_t readPort(uint16_t port) override;
+    void writePort(uint16_t port, uint8_t value) override;
+    bool ecReadRange(uint16_t addr, uint8_t* out, size_t len) override;
+    bool ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) override;
+    bool executePortProgram(const ec_protocol::PortOp* ops, size_t count, uint8_t* results) override;
+    bool setWaitPolicy(const EcWaitPolicy& policy) override;
+    bool waitHistogram(EcWaitHistogram& out, bool reset) override;
+    const char* name() const override { return "WinRing0"; }
+
+private:
+    void* hWinRing0Wrapper = nullptr; // Use void* for HMODULE
+    typedef bool (*LoadWinRing0_t)();
+    typedef bool (*InitWinRing0_t)();
+    typedef uint8_t (*ReadPort_t)(uint16_t port);
+    typedef void (*WritePort_t)(uint16_t port, uint8_t value);
+    typedef uint32_t (*GetStatus_t)();
+    typedef void (*DeinitWinRing0_t)();
+    typedef int32_t (*EcReadRange_t)(uint16_t addr, size_t len, uint8_t* out);          // Returns BOOL
+    typedef int32_t (*EcWriteRange_t)(uint16_t addr, const uint8_t* in, size_t len);    // Returns BOOL
+    typedef size_t (*ExecutePortProgram_t)(const ec_protocol::PortOp* ops, size_t count, uint8_t* results); // Ops run
+    typedef void (*SetEcReadyCheck_t)(uint16_t statusPort, uint8_t mask, uint8_t value);
+    typedef void (*SetEcWaitPolicy_t)(uint32_t spinNs, uint32_t yieldNs, uint32_t timeoutMs);
+    typedef int32_t (*GetEcWaitHistogram_t)(EcWaitHistogram* out, int32_t reset);       // Returns BOOL
+
+    LoadWinRing0_t pLoadWinRing0 = nullptr;
+    InitWinRing0_t pInitWinRing0 = nullptr;
+    ReadPort_t pReadPort = nullptr;
+    WritePort_t pWritePort = nullptr;
+    GetStatus_t pGetStatus = nullptr;
+    DeinitWinRing0_t pDeinitWinRing0 = nullptr;
+    EcReadRange_t pEcReadRange = nullptr;   // Optional (newer wrapper builds)
+    EcWriteRange_t pEcWriteRange = nullptr; // Optional (newer wrapper builds)
+    ExecutePortProgram_t pExecutePortProgram = nullptr; // Optional
+    SetEcReadyCheck_t pSetEcReadyCheck = nullptr;       // Optional
+    SetEcWaitPolicy_t pSetEcWaitPolicy = nullptr;       // Optional
+    GetEcWaitHistogram_t pGetEcWaitHistogram = nullptr; // Optional
+
+    bool initialized = false;
+
+    void unload();
+};
+#endif
+
+#ifdef FAN_CONTROL_HAS_IOPERM
+// Direct port access on x86 Linux via ioperm(0x4E, 2, 1) and inline inb/outb: no driver shim
+// and no syscall per port op. Needs root or CAP_SYS_RAWIO. Range ops run the full SuperIO
+// sequence with the port instructions inlined into the loop.
+class IopermPortBackend : public PortBackend {
+public:
+    ~IopermPortBackend() override;
+
+    bool open(std::string& error) override;
+    void close() override;
+    uint8_t readPort(uint16_t port) override;
+    void writePort(uint16_t port, uint8_t value) override;
+    bool ecReadRange(uint16_t addr, uint8_t* out, size_t len) override;
+    bool ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) override;
+    const char* name() const override { return "ioperm"; }
+
+private:
+    bool granted = false;
+};
+#endif
+
+#ifdef FAN_CONTROL_HAS_DEV_PORT
+// Port access through /dev/port for hosts where ioperm is not permitted. Single port ops are
+// one pread/pwrite each. Range ops queue the whole SuperIO sequence as linked (strictly
+// ordered) 1-byte write/read SQEs and submit them with a single io_uring_enter; port programs
+// go out the same way. Without io_uring, both are declined and FanController uses the per-op path.
+class DevPortBackend : public PortBackend {
+public:
+    // path can point at a regular file to stand in for /dev/port when measuring
+    explicit DevPortBackend(const std::string& devicePath = "/dev/port");
+    ~DevPortBackend() override;
+
+    bool open(std::string& error) override;
+    void close() override;
+    uint8_t readPort(uint16_t port) override;
+    void writePort(uint16_t port, uint8_t value) override;
+    bool ecReadRange(uint16_t addr, uint8_t* out, size_t len) override;
+    bool ecWriteRange(uint16_t addr, const uint8_t* data, size_t len) override;
+    bool executePortProgram(const ec_protocol::PortOp* ops, size_t count, uint8_t* results) override;
+    bool needsSystemLock() const override { return !stand_in; }
+    const char* name() const override { return usingIoUring() ? "dev-port (io_uring)" : "dev-port"; }
+
+    bool usingIoUring() const { return ring != nullptr; }
+
+    // Syscalls (pread, pwrite, io_uring_enter) and port ops issued since open or resetCounters()
+    uint64_t syscalls() const { return syscall_count; }
+    uint64_t portOps() const { return port_op_count; }
+    void resetCounters();
+
+private:
+    struct Ring;    // io_uring state, defined in port_backend.cpp
+    struct BatchIo; // ec_protocol Io that queues ops into batch
+
+    // One queued 1-byte port access
+    struct PendingOp {
+        bool is_read;
+        uint16_t port;
+        uint8_t value; // Write source
+        uint8_t* dst;  // Read destination
+    };
+
+    std::string path;
+    int fd = -1;
+    bool stand_in = false; // path is a regular file, not the port device
+    std::unique_ptr<Ring> ring;
+    std::vector<PendingOp> batch;
+    uint64_t syscall_count = 0;
+    uint64_t port_op_count = 0;
+
+    bool submitBatch();
+    void runBatchSync();
+};
+#endif
+
+// In-process ITE EC simulator. Emulates the SuperIO index/data protocol on ports 0x4E/0x4F
+// (SuperIO register 0x2E selects a D2EC register, 0x2F accesses it; D2EC 0x11/0x10 hold the
+// address high/low byte and 0x12 reads or writes EC RAM) over a 64 KiB EC address space.
+// Every port op can be given a fixed busy-wait latency to model a driver round-trip.
+class SimulatedEcPortBackend : public PortBackend {
+public:
+    SimulatedEcPortBackend();
+
+    bool open(std::string& error) override;
+    void close() override;
+    uint8_t readPort(uint16_t port) override;
+    void writePort(uint16_t port, uint8_t value) override;
+    bool needsSystemLock() const override { return false; } // No real ports to share
+    const char* name() const override { return "Simulator"; }
+
+    // Per-op latency applied to every readPort/writePort
+    void setLatency(std::chrono::nanoseconds latency);
+
+    // Direct EC RAM access that bypasses the port protocol (test setup / inspection)
+    uint8_t peek(uint16_t addr) const;
+    void poke(uint16_t addr, uint8_t value);
+
+    // Port-op counters since construction or the last resetCounters()
+    uint64_t portReads() const { return port_reads; }
+    uint64_t portWrites() const { return port_writes; }
+    void resetCounters();
+
+private:
+    static const uint16_t SIO_INDEX_PORT = 0x4E;
+    static const uint16_t SIO_DATA_PORT = 0x4F;
+
+    std::vector<uint8_t> ec_ram; // 64 KiB
+    std::chrono::nanoseconds op_latency{0};
+    bool is_open = false;
+
+    uint8_t sio_index = 0;  // Last value written to 0x4E
+    uint8_t d2_index = 0;   // SuperIO 0x2E: selected D2EC register
+    uint8_t addr_hi = 0;    // D2EC 0x11
+    uint8_t addr_lo = 0;    // D2EC 0x10
+
+    uint64_t port_reads = 0;
+    uint64_t port_writes = 0;
+
+    void spendLatency() const;
+    uint16_t ecAddress() const { return static_cast<uint16_t>((addr_hi << 8) | addr_lo); }
+};
+
+#endif // PORT_BACKEND_H
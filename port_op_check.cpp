@@ -0,0 +1,70 @@
+// Port-op regression check: runs readStatus/pollStatus/writeConfig against the EC simulator
+// and compares the number of port reads and writes with the expected counts. Any change to
+// the read plan, latch elision or write path shows up here as a count change.
+// Built only with -DFAN_CONTROL_SIM_CHECKS=ON; returns nonzero on a mismatch.
+#include "fan_control.h"
+#include <stdio.h>
+
+namespace {
+    struct Expected {
+        const char* name;
+        uint64_t ops;
+    };
+
+    // Update these together with any intended change to the EC access pattern
+    const Expected READ_STATUS = { "readStatus", 916 };         // Cold shadow: the whole read plan
+    const Expected POLL_STATUS = { "pollStatus", 72 };          // Telemetry only, config from the shadow
+    const Expected WRITE_CONFIG = { "writeConfig", 96 };        // 2 bytes sent, duty and ACC/DEC update
+
+    bool check(const Expected& expected, SimulatedEcPortBackend& sim) {
+        const uint64_t ops = sim.portReads() + sim.portWrites();
+        const bool ok = ops == expected.ops;
+        printf("%-12s %6llu port ops (%llu reads, %llu writes), expected %llu%s\n", expected.name,
+               static_cast<unsigned long long>(ops), static_cast<unsigned long long>(sim.portReads()),
+               static_cast<unsigned long long>(sim.portWrites()), static_cast<unsigned long long>(expected.ops),
+               ok ? "" : "  MISMATCH");
+        sim.resetCounters();
+        return ok;
+    }
+} // end anonymous namespace
+
+int main() {
+    SimulatedEcPortBackend* sim = new SimulatedEcPortBackend();
+    FanController controller{ std::unique_ptr<PortBackend>(sim) };
+    if (!controller.initialize()) {
+        printf("initialize failed: %s\n", controller.getLastError().c_str());
+        return 1;
+    }
+
+    bool ok = true;
+    FanStatusData status;
+    sim->resetCounters();
+    if (!controller.readStatus(status)) {
+        printf("readStatus failed: %s\n", controller.getLastError().c_str());
+        return 1;
+    }
+    ok = check(READ_STATUS, *sim) && ok;
+
+    if (!controller.pollStatus(status)) {
+        printf("pollStatus failed: %s\n", controller.getLastError().c_str());
+        return 1;
+    }
+    ok = check(POLL_STATUS, *sim) && ok;
+
+    // Two changed bytes on top of what the EC holds. The tables were just read above, so they
+    // are fresh in the shadow and only the changed bytes go out.
+    FanConfigData config;
+    config.fan1_curve[4] = 99;
+    config.cpu_lower_temp[5] = 1;
+    if (!controller.writeConfig(config)) {
+        printf("writeConfig failed: %s\n", controller.getLastError().c_str());
+        return 1;
+    }
+    ok = check(WRITE_CONFIG, *sim) && ok;
+
+    if (sim->peek(0xC544) != 99 || sim->peek(0xC595) != 1) {
+        printf("writeConfig did not reach the simulated EC\n");
+        ok = false;
+    }
+    return ok ? 0 : 1;
+}
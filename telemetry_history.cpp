@@ -0,0 +1,49 @@
+#include "telemetry_history.h"
+
+TelemetryHistory::TelemetryHistory(size_t capacity) {
+    if (capacity == 0) {
+        capacity = 1;
+    }
+    time_s.assign(capacity, 0.0);
+    fan1_rpm.assign(capacity, 0.0);
+    fan2_rpm.assign(capacity, 0.0);
+    fan1_percent.assign(capacity, 0.0);
+    fan2_percent.assign(capacity, 0.0);
+    fan1_target_duty.assign(capacity, 0.0);
+    fan2_target_duty.assign(capacity, 0.0);
+    cur_point.assign(capacity, 0.0);
+}
+
+bool TelemetryHistory::push(const FanStatusData& status) {
+    if ((status.fresh_fields & STATUS_TELEMETRY) != STATUS_TELEMETRY || status.sample_time_us == 0) {
+        return false;
+    }
+    if (count == 0) {
+        base_time_us = status.sample_time_us;
+    } else if (status.sample_time_us <= last_time_us) {
+        return false;
+    }
+    last_time_us = status.sample_time_us;
+
+    time_s[head] = static_cast<double>(status.sample_time_us - base_time_us) * 1e-6;
+    fan1_rpm[head] = status.fan1_speed;
+    fan2_rpm[head] = status.fan2_speed;
+    fan1_percent[head] = status.fan1_percent;
+    fan2_percent[head] = status.fan2_percent;
+    fan1_target_duty[head] = status.fan1_target_duty;
+    fan2_target_duty[head] = status.fan2_target_duty;
+    cur_point[head] = status.fan_cur_point;
+
+    head = (head + 1) % capacity();
+    if (count < capacity()) {
+        ++count;
+    }
+    return true;
+}
+
+void TelemetryHistory::clear() {
+    head = 0;
+    count = 0;
+    base_time_us = 0;
+    last_time_us = 0;
+}
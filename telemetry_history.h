@@ -0,0 +1,66 @@
+#ifndef TELEMETRY_HISTORY_H
+#define TELEMETRY_HISTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "fan_control.h"
+
+// Fixed-capacity history of telemetry samples for the live chart. Storage is one array per
+// channel (structure of arrays), allocated once in the constructor and overwritten in place
+// once full, so pushing a sample and plotting the history never allocate or copy.
+//
+// Arrays are laid out in ring order. ImPlot reads them directly with offset() and size():
+// PlotLine(label, times(), fan1Rpm(), size(), 0, offset()).
+class TelemetryHistory {
+public:
+    // 10 minutes at the worker's default 10 Hz poll rate
+    static const size_t DEFAULT_CAPACITY = 6000;
+
+    explicit TelemetryHistory(size_t capacity = DEFAULT_CAPACITY);
+
+    // Appends the telemetry part of a status read. Samples without a timestamp or older than
+    // the newest one (e.g. a cached snapshot published again) are dropped. Returns whether
+    // the sample was stored.
+    bool push(const FanStatusData& status);
+
+    void clear();
+
+    size_t size() const { return count; }
+    size_t capacity() const { return time_s.size(); }
+    bool empty() const { return count == 0; }
+
+    // Index of the oldest sample; ImPlot's offset argument
+    int offset() const { return count < capacity() ? 0 : static_cast<int>(head); }
+
+    // Seconds since the first sample after construction or clear(), and the newest value
+    double latestTime() const { return count ? time_s[newestIndex()] : 0.0; }
+
+    const double* times() const { return time_s.data(); }
+    const double* fan1Rpm() const { return fan1_rpm.data(); }
+    const double* fan2Rpm() const { return fan2_rpm.data(); }
+    const double* fan1Percent() const { return fan1_percent.data(); }
+    const double* fan2Percent() const { return fan2_percent.data(); }
+    const double* fan1TargetDuty() const { return fan1_target_duty.data(); }
+    const double* fan2TargetDuty() const { return fan2_target_duty.data(); }
+    const double* curvePoint() const { return cur_point.data(); }
+
+private:
+    std::vector<double> time_s;
+    std::vector<double> fan1_rpm;
+    std::vector<double> fan2_rpm;
+    std::vector<double> fan1_percent;
+    std::vector<double> fan2_percent;
+    std::vector<double> fan1_target_duty;
+    std::vector<double> fan2_target_duty;
+    std::vector<double> cur_point; // Curve point the EC is on (shared by both fans)
+
+    size_t head = 0;  // Next slot to write
+    size_t count = 0;
+    int64_t base_time_us = 0;   // sample_time_us of the first sample
+    int64_t last_time_us = 0;
+
+    size_t newestIndex() const { return (head + capacity() - 1) % capacity(); }
+};
+
+#endif // TELEMETRY_HISTORY_H
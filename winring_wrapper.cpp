@@ -3,6 +3,8 @@
 #include <string>   // For std::string
 #include <vector>   // For path manipulation buffer
 #include <libloaderapi.h> // For GetModuleFileName
+#include "ec_protocol.h" // SuperIO/D2EC sequence shared with FanController backends
+#include "ec_wait.h"     // Adaptive spin/yield/sleep ready-wait
 
 // Define function pointer types
 typedef BOOL (WINAPI *InitializeOls_t)();
@@ -22,6 +24,30 @@ BOOL winRingLoaded = FALSE;
 BOOL winRingInitialized = FALSE;
 DWORD lastLoadError = 0; // Variable to store LoadLibrary error
 
+// Optional EC ready handshake polled before every port op. Off until SetEcReadyCheck is called;
+// WinRing0PortBackend enables (0x66, 0x02, 0x00), the ACPI EC input buffer drain, only when
+// its wait policy opts in, and reads the wait statistics back through GetEcWaitHistogram.
+// The check switches itself off again once the waiter trips (EcReadyWaiter::BREAKER_TIMEOUTS
+// timeouts in a row), e.g. on a Super I/O EC that has no ACPI status port.
+WORD readyStatusPort = 0;
+BYTE readyMask = 0;
+BYTE readyValue = 0;
+EcReadyWaiter readyWaiter;
+
+// Waits for the configured ready condition. A timeout is recorded in the histogram and the
+// op goes ahead anyway, like the unconditional access it replaces.
+static void WaitEcReady() {
+    if (readyStatusPort == 0) {
+        return;
+    }
+    const bool ready = readyWaiter.wait([] {
+        return (ReadIoPortByteFunc(readyStatusPort) & readyMask) == readyValue;
+    });
+    if (!ready && readyWaiter.tripped()) {
+        readyStatusPort = 0; // Circuit breaker: stop paying the timeout on every op
+    }
+}
+
 // Helper function to get the directory of the current module (the wrapper DLL)
 std::wstring GetModuleDirectory(HMODULE hModule) {
     std::vector<wchar_t> pathBuf;
@@ -123,8 +149,7 @@ extern "C" __declspec(dllexport) BYTE ReadPort(WORD port) {
     if (!winRingInitialized || !ReadIoPortByteFunc) {
         return 0; // Or some other error indicator
     }
-    // Add small delay matching _ec_wait() if necessary for stability
-    // Sleep(1); // Example: 1 millisecond delay
+    WaitEcReady(); // Replaces a fixed Sleep(1) per op (the old _ec_wait())
     return ReadIoPortByteFunc(port);
 }
 
@@ -133,11 +158,88 @@ extern "C" __declspec(dllexport) VOID WritePort(WORD port, BYTE value) {
     if (!winRingInitialized || !WriteIoPortByteFunc) {
         return;
     }
-    // Add small delay matching _ec_wait() if necessary for stability
-    // Sleep(1); // Example: 1 millisecond delay
+    WaitEcReady();
     WriteIoPortByteFunc(port, value);
 }
 
+// Adapts the WinRing0 port functions to the ec_protocol Io interface
+struct WinRingPortIo {
+    void in(WORD port, BYTE* dst) { WaitEcReady(); *dst = ReadIoPortByteFunc(port); }
+    void out(WORD port, BYTE value) { WaitEcReady(); WriteIoPortByteFunc(port, value); }
+};
+
+// Exported function to run a whole list of port ops in one call.
+// Each read stores its value in the next slot of results (which must hold one byte per read op).
+// Returns the number of ops executed (0 if not initialized).
+extern "C" __declspec(dllexport) size_t ExecutePortProgram(const ec_protocol::PortOp* ops, size_t count, BYTE* results) {
+    if (!winRingInitialized || !ReadIoPortByteFunc || !WriteIoPortByteFunc || !ops) {
+        return 0;
+    }
+    size_t read_index = 0;
+    for (size_t i = 0; i < count; ++i) {
+        WaitEcReady();
+        if (ops[i].is_read) {
+            BYTE value = ReadIoPortByteFunc(ops[i].port);
+            if (results) results[read_index] = value;
+            ++read_index;
+        } else {
+            WriteIoPortByteFunc(ops[i].port, ops[i].value);
+        }
+    }
+    return count;
+}
+
+// Exported function to read len bytes of EC RAM starting at addr. Runs the full SuperIO index
+// sequence here, only reprogramming the address latch bytes that change.
+extern "C" __declspec(dllexport) BOOL EcReadRange(WORD addr, size_t len, BYTE* out) {
+    if (!winRingInitialized || !ReadIoPortByteFunc || !WriteIoPortByteFunc || !out) {
+        return FALSE;
+    }
+    WinRingPortIo io;
+    ec_protocol::readRange(io, addr, out, len);
+    return TRUE;
+}
+
+// Exported function to write len bytes of EC RAM starting at addr
+extern "C" __declspec(dllexport) BOOL EcWriteRange(WORD addr, const BYTE* in, size_t len) {
+    if (!winRingInitialized || !ReadIoPortByteFunc || !WriteIoPortByteFunc || !in) {
+        return FALSE;
+    }
+    WinRingPortIo io;
+    ec_protocol::writeRange(io, addr, in, len);
+    return TRUE;
+}
+
+// Exported function to enable (statusPort != 0) or disable the ready check before each port op:
+// waits until (inb(statusPort) & mask) == value. Also rearms a tripped circuit breaker.
+extern "C" __declspec(dllexport) VOID SetEcReadyCheck(WORD statusPort, BYTE mask, BYTE value) {
+    readyStatusPort = statusPort;
+    readyMask = mask;
+    readyValue = value;
+    readyWaiter.rearm();
+}
+
+// Exported function to tune the ready-wait phases (0 keeps the current value)
+extern "C" __declspec(dllexport) VOID SetEcWaitPolicy(DWORD spinNs, DWORD yieldNs, DWORD timeoutMs) {
+    EcWaitPolicy policy = readyWaiter.getPolicy();
+    if (spinNs) policy.spin_budget = std::chrono::nanoseconds(spinNs);
+    if (yieldNs) policy.yield_budget = std::chrono::nanoseconds(yieldNs);
+    if (timeoutMs) policy.timeout = std::chrono::milliseconds(timeoutMs);
+    readyWaiter.setPolicy(policy);
+}
+
+// Exported function to copy out the ready-wait histogram, optionally resetting it
+extern "C" __declspec(dllexport) BOOL GetEcWaitHistogram(EcWaitHistogram* out, BOOL reset) {
+    if (!out) {
+        return FALSE;
+    }
+    *out = readyWaiter.histogram();
+    if (reset) {
+        readyWaiter.resetHistogram();
+    }
+    return TRUE;
+}
+
 // Exported function to get WinRing0 status OR the LoadLibrary error
 extern "C" __declspec(dllexport) DWORD GetStatus() {
     // If loading failed, return the LoadLibrary error code